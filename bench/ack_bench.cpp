@@ -0,0 +1,55 @@
+#include "bench.hpp"
+#include <rakro/packet/ack.hpp>
+#include <rakro/packet/ack_records.hpp>
+#include <vector>
+
+namespace {
+    using namespace rakro;
+
+    constexpr size_t acked_per_datagram = 256;
+
+    // Runs of 7 received datagrams with one lost between them, which is about what a lossy
+    // mobile link acks in a tick
+    std::vector<uint24_t> make_received_sequences() {
+        auto sequences = std::vector<uint24_t>();
+        for (uint32_t x = 0; sequences.size() < acked_per_datagram; x++) {
+            if (x % 8 != 7) {
+                sequences.push_back(uint24_t(0xFFFF00 + x)); // crosses the 24 bit wrap
+            }
+        }
+        return sequences;
+    }
+} // namespace
+
+RAKRO_BENCH(ack_encode_sequences) {
+    const auto sequences = make_received_sequences();
+    auto       memory    = std::vector<uint8_t>(1400);
+
+    state.set_items_per_iteration(sequences.size());
+    while (state.keep_running()) {
+        auto buffer = BinaryBuffer(RentedBuffer(memory, nullptr));
+        bench::do_not_optimize(packets::write_ack_records(PacketId::Ack, sequences, buffer));
+    }
+}
+
+// Decoding plus walking every record, which is what process_ack does before touching the
+// resend buffer
+RAKRO_BENCH(ack_decode_records) {
+    const auto sequences = make_received_sequences();
+    auto       memory    = std::vector<uint8_t>(1400);
+    auto       buffer    = BinaryBuffer(RentedBuffer(memory, nullptr));
+    packets::write_ack_records(PacketId::Ack, sequences, buffer);
+
+    const auto datagram = buffer.consumed_slice();
+
+    state.set_items_per_iteration(sequences.size());
+    while (state.keep_running()) {
+        const auto ack   = packets::Ack::from_bytes(datagram);
+        uint32_t   acked = 0;
+
+        for (const auto range : ack->records) {
+            acked += range.size();
+        }
+        bench::do_not_optimize(acked);
+    }
+}
@@ -0,0 +1,81 @@
+#include "bench.hpp"
+#include <rakro/internal/address_table.hpp>
+#include <rakro/internal/net.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    using namespace rakro;
+
+    constexpr size_t connections    = 16384;
+    constexpr size_t lookups_per_op = 4096;
+
+    // Spread over a few /16s and the whole port range, like real clients behind NATs
+    std::vector<detail::IPV4Addr> make_addresses() {
+        auto addresses = std::vector<detail::IPV4Addr>(connections);
+
+        for (size_t x = 0; x < connections; x++) {
+            auto& address           = addresses[x].address;
+            address.sin_family      = AF_INET;
+            address.sin_addr.s_addr = htonl(static_cast<uint32_t>(0x0A000000 + x * 7919));
+            address.sin_port        = htons(static_cast<uint16_t>(1024 + x * 31));
+        }
+        return addresses;
+    }
+
+    // Every datagram looks its connection up once, in no particular order
+    std::vector<size_t> make_lookup_order() {
+        auto order = std::vector<size_t>(lookups_per_op);
+        auto state = uint64_t{0x2545F4914F6CDD1D};
+
+        for (auto& index : order) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            index = static_cast<size_t>(state % connections);
+        }
+        return order;
+    }
+
+    void bench_address_table(bench::State& state) {
+        const auto addresses = make_addresses();
+        const auto order     = make_lookup_order();
+
+        auto table = AddressTable<uint64_t>();
+        for (size_t x = 0; x < connections; x++) {
+            table.insert(addresses[x], uint64_t{x});
+        }
+
+        state.set_items_per_iteration(lookups_per_op);
+        while (state.keep_running()) {
+            uint64_t sum = 0;
+            for (const auto index : order) {
+                sum += *table.find(addresses[index]);
+            }
+            bench::do_not_optimize(sum);
+        }
+    }
+
+    // What ClientRouter used before, for comparison
+    void bench_unordered_map(bench::State& state) {
+        const auto addresses = make_addresses();
+        const auto order     = make_lookup_order();
+
+        auto map = std::unordered_map<detail::IPV4Addr, uint64_t>();
+        for (size_t x = 0; x < connections; x++) {
+            map.insert({addresses[x], uint64_t{x}});
+        }
+
+        state.set_items_per_iteration(lookups_per_op);
+        while (state.keep_running()) {
+            uint64_t sum = 0;
+            for (const auto index : order) {
+                sum += map.find(addresses[index])->second;
+            }
+            bench::do_not_optimize(sum);
+        }
+    }
+} // namespace
+
+RAKRO_BENCH(address_table_lookup_16k) { bench_address_table(state); }
+RAKRO_BENCH(unordered_map_lookup_16k) { bench_unordered_map(state); }
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rakro::bench {
+
+    // Stops the optimiser from throwing away a value we computed only to measure it
+    inline const void* volatile sink{nullptr};
+
+    template <typename T> void do_not_optimize(const T& value) noexcept {
+        sink = &value;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    }
+
+    class State {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        explicit State(size_t iterations) : iterations(iterations) {}
+
+        // Starts the clock on the first call and stops it once every iteration has been used,
+        // written as `while (state.keep_running()) { ... }`
+        bool keep_running() noexcept {
+            if (this->done == 0) {
+                this->start = Clock::now();
+            }
+
+            if (this->done == this->iterations) {
+                this->elapsed += Clock::now() - this->start;
+                return false;
+            }
+
+            this->done++;
+            return true;
+        }
+
+        void pause_timing() noexcept { this->elapsed += Clock::now() - this->start; }
+        void resume_timing() noexcept { this->start = Clock::now(); }
+
+        // What a single iteration counts as, e.g. datagrams per batch, reported as ns/item
+        void set_items_per_iteration(size_t items) noexcept {
+            this->items_per_iteration = items;
+        }
+
+        size_t get_iterations() const noexcept { return this->iterations; }
+        size_t get_items_per_iteration() const noexcept { return this->items_per_iteration; }
+        Clock::duration get_elapsed() const noexcept { return this->elapsed; }
+
+    private:
+        size_t            iterations{};
+        size_t            done{0};
+        size_t            items_per_iteration{1};
+        Clock::time_point start{};
+        Clock::duration   elapsed{};
+    };
+
+    using BenchFunction = void (*)(State&);
+
+    struct Benchmark {
+        std::string   name{};
+        BenchFunction function{nullptr};
+    };
+
+    inline std::vector<Benchmark>& registry() {
+        static std::vector<Benchmark> benchmarks{};
+        return benchmarks;
+    }
+
+    struct Registrar {
+        Registrar(const char* name, BenchFunction function) {
+            registry().push_back(Benchmark{.name = name, .function = function});
+        }
+    };
+} // namespace rakro::bench
+
+#define RAKRO_BENCH(name)                                                                      \
+    static void                              name(rakro::bench::State& state);                 \
+    static const rakro::bench::Registrar name##_registrar{#name, &name};                       \
+    static void                              name(rakro::bench::State& state)
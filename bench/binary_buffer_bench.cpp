@@ -0,0 +1,195 @@
+#include "bench.hpp"
+#include <algorithm>
+#include <rakro/internal/binary_buffer.hpp>
+#include <rakro/packet/ack.hpp>
+#include <rakro/packet/connected_ping_pong.hpp>
+#include <rakro/packet/connection_request.hpp>
+#include <rakro/packet/connection_request_accepted.hpp>
+#include <rakro/packet/frame_set.hpp>
+#include <rakro/packet/incompatible_protocol.hpp>
+#include <rakro/packet/magic.hpp>
+#include <rakro/packet/nack.hpp>
+#include <rakro/packet/open_connection_reply_one.hpp>
+#include <rakro/packet/open_connection_reply_two.hpp>
+#include <rakro/packet/open_connection_request_one.hpp>
+#include <rakro/packet/open_connection_request_two.hpp>
+#include <rakro/packet/rak_address.hpp>
+#include <rakro/packet/unconnected_ping.hpp>
+#include <rakro/packet/unconnected_pong.hpp>
+#include <string>
+#include <vector>
+
+// One write and one read benchmark for every BinaryDataInterface specialisation, apart from
+// the directions the packet never goes in (those throw "unimplemented")
+namespace {
+    using namespace rakro;
+
+    constexpr size_t values_per_op = 64;
+
+    template <typename T> void bench_write(bench::State& state, const T& value) {
+        // Not every type reports a usable size(), a page per value is plenty for all of them
+        auto memory = std::vector<uint8_t>(values_per_op * 4096);
+
+        state.set_items_per_iteration(values_per_op);
+        while (state.keep_running()) {
+            auto buffer = BinaryBuffer(RentedBuffer(memory, nullptr));
+            for (size_t x = 0; x < values_per_op; x++) {
+                buffer.write(value);
+            }
+            bench::do_not_optimize(memory);
+        }
+    }
+
+    // Every value gets its own buffer, some readers (OpenConnectionRequest1) eat everything
+    // left in the buffer
+    template <typename T> void bench_read(bench::State& state, std::vector<uint8_t> encoded) {
+        auto memory = std::vector<uint8_t>();
+        for (size_t x = 0; x < values_per_op; x++) {
+            memory.insert(memory.end(), encoded.begin(), encoded.end());
+        }
+
+        state.set_items_per_iteration(values_per_op);
+        while (state.keep_running()) {
+            for (size_t x = 0; x < values_per_op; x++) {
+                const auto offset = x * encoded.size();
+                auto       slice  = std::span(memory).subspan(offset, encoded.size());
+                auto       buffer = BinaryBuffer(RentedBuffer(slice, nullptr));
+                const auto value  = buffer.read_next<T>();
+                bench::do_not_optimize(value);
+            }
+        }
+    }
+
+    template <typename T> std::vector<uint8_t> encode(const T& value) {
+        auto memory = std::vector<uint8_t>(4096);
+        auto buffer = BinaryBuffer(RentedBuffer(memory, nullptr));
+        buffer.write(value);
+        memory.resize(buffer.consumed());
+        return memory;
+    }
+
+    std::vector<uint8_t> encode_raw_address() {
+        return encode(packets::RakAddress{.ip = 0x7F000001, .port = 19132});
+    }
+
+    packets::FrameInfo sample_frame_info() {
+        return packets::FrameInfo{
+            .body_leng         = 120,
+            .rely              = packets::FrameReliability::ReliableOrdered,
+            .reliability_index = uint24_t(4000),
+            .order_info =
+                packets::FrameInfo::OrderInformation{.order_frame_index = uint24_t(12)}
+        };
+    }
+
+    std::vector<uint8_t> encode_ack(PacketId id) {
+        auto       memory   = std::vector<uint8_t>(1400);
+        auto       buffer   = BinaryBuffer(RentedBuffer(memory, nullptr));
+        const auto sequence = std::vector<uint24_t>{1, 2, 3, 4, 8, 10, 11, 12, 20};
+        packets::write_ack_records(id, sequence, buffer);
+        memory.resize(buffer.consumed());
+        return memory;
+    }
+
+    // Acks only view their records, so the bytes they were read from stay around for good
+    template <typename T> T sample_ack(PacketId id) {
+        static const auto encoded = encode_ack(id);
+        return T::from_bytes(encoded).value();
+    }
+
+    std::vector<uint8_t> encode_ocr1() {
+        // magic | protocol | MTU padding
+        auto memory = std::vector<uint8_t>(sizeof(MagicType) + 1 + 1200, 0);
+        std::ranges::copy(Magic, memory.begin());
+        memory[sizeof(MagicType)] = 11;
+        return memory;
+    }
+
+    std::vector<uint8_t> encode_ocr2() {
+        auto memory  = std::vector<uint8_t>(Magic.begin(), Magic.end());
+        auto address = encode_raw_address();
+        memory.insert(memory.end(), address.begin(), address.end());
+        memory.insert(memory.end(), {0x05, 0xD4}); // 1492 MTU
+        memory.insert(memory.end(), 8, 0xAB);     // guid
+        return memory;
+    }
+} // namespace
+
+#define RAKRO_BENCH_WRITE(name, ...)                                                           \
+    RAKRO_BENCH(binary_write_##name) { bench_write(state, __VA_ARGS__); }
+
+#define RAKRO_BENCH_READ(name, type, ...)                                                      \
+    RAKRO_BENCH(binary_read_##name) { bench_read<type>(state, __VA_ARGS__); }
+
+#define RAKRO_BENCH_INTEGRAL(type, value)                                                      \
+    RAKRO_BENCH_WRITE(type, type(value))                                                       \
+    RAKRO_BENCH_READ(type, type, encode(type(value)))
+
+RAKRO_BENCH_INTEGRAL(uint8_t, 0x12)
+RAKRO_BENCH_INTEGRAL(int8_t, -12)
+RAKRO_BENCH_INTEGRAL(uint16_t, 0x1234)
+RAKRO_BENCH_INTEGRAL(int16_t, -1234)
+RAKRO_BENCH_INTEGRAL(uint32_t, 0x12345678)
+RAKRO_BENCH_INTEGRAL(int32_t, -12345678)
+RAKRO_BENCH_INTEGRAL(uint64_t, 0x123456789ABCDEF0)
+RAKRO_BENCH_INTEGRAL(int64_t, -123456789)
+RAKRO_BENCH_INTEGRAL(char, 'r')
+RAKRO_BENCH_INTEGRAL(bool, true)
+RAKRO_BENCH_INTEGRAL(uint24_t, 0x123456)
+
+RAKRO_BENCH_WRITE(string, std::string("MCPE;Dedicated Server;782;1.21.71;0;10;"))
+RAKRO_BENCH_READ(string, std::string, encode(std::string("MCPE;Dedicated Server;782;1.21.71")))
+
+RAKRO_BENCH_WRITE(magic, Magic)
+RAKRO_BENCH_READ(magic, MagicType, encode(Magic))
+
+RAKRO_BENCH_WRITE(rak_address, packets::RakAddress{.ip = 0x7F000001, .port = 19132})
+RAKRO_BENCH_READ(rak_address, packets::RakAddress, encode_raw_address())
+
+RAKRO_BENCH_WRITE(frame_header, packets::FrameHeader{.sequence_number = 1234})
+RAKRO_BENCH_READ(frame_header, packets::FrameHeader, encode(packets::FrameHeader{}))
+
+RAKRO_BENCH_WRITE(frame_info, sample_frame_info())
+RAKRO_BENCH_READ(frame_info, packets::FrameInfo, encode(sample_frame_info()))
+
+RAKRO_BENCH_WRITE(ack, sample_ack<packets::Ack>(PacketId::Ack))
+RAKRO_BENCH_READ(ack, packets::Ack, encode_ack(PacketId::Ack))
+
+RAKRO_BENCH_WRITE(nack, sample_ack<packets::Nack>(PacketId::Nack))
+RAKRO_BENCH_READ(nack, packets::Nack, encode_ack(PacketId::Nack))
+
+RAKRO_BENCH_WRITE(connected_ping, packets::ConnectedPing{.time_since_start = 1})
+RAKRO_BENCH_READ(connected_ping, packets::ConnectedPing, std::vector<uint8_t>(8, 0x11))
+
+RAKRO_BENCH_WRITE(connected_pong, packets::ConnectedPong{.time_since_start = 1})
+RAKRO_BENCH_READ(connected_pong, packets::ConnectedPong, std::vector<uint8_t>(16, 0x11))
+
+RAKRO_BENCH_READ(
+    connection_request, packets::ConnectionRequest, std::vector<uint8_t>(8 + 8 + 1, 0)
+)
+RAKRO_BENCH_WRITE(
+    connection_request_accepted,
+    packets::ConnectionRequestAccepted{.client_address = {.ip = 0x7F000001, .port = 19132}}
+)
+
+RAKRO_BENCH_WRITE(incompatible_protocol, packets::IncompatibleProtocol{.client_protocol = 10})
+
+RAKRO_BENCH_READ(open_connection_request_1, packets::OpenConnectionRequest1, encode_ocr1())
+RAKRO_BENCH_WRITE(open_connection_reply_1, packets::OpenConnectionReply1{.MTU = 1400})
+
+RAKRO_BENCH_READ(open_connection_request_2, packets::OpenConnectionRequest2, encode_ocr2())
+RAKRO_BENCH_WRITE(open_connection_reply_2, packets::OpenConnectionReply2{.MTU = 1400})
+
+RAKRO_BENCH_WRITE(unconnected_ping, packets::UnconnectedPing{.time = 1, .client_guid = 2})
+RAKRO_BENCH_READ(
+    unconnected_ping, packets::UnconnectedPing,
+    encode(packets::UnconnectedPing{.time = 1, .client_guid = 2})
+)
+
+RAKRO_BENCH_WRITE(
+    unconnected_pong,
+    packets::UnconnectedPong(
+        "MCPE;Dedicated Server;782;1.21.71;0;10;13253860892328930865;Bedrock level;Survival;1;",
+        0xDEADC0DE
+    )
+)
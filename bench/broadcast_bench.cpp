@@ -0,0 +1,115 @@
+#include "bench.hpp"
+#include <memory>
+#include <rakro/internal/buffer_company.hpp>
+#include <rakro/internal/net.hpp>
+#include <rakro/packet/frame_set.hpp>
+#include <rakro/server/outbox.hpp>
+#include <rakro/server/server_client.hpp>
+#include <vector>
+
+namespace {
+    using namespace rakro;
+
+    constexpr size_t recipients  = 1000;
+    constexpr size_t update_size = 512; // One world update, fits in a single frame
+
+    detail::IPV4Addr recipient_address(size_t recipient) {
+        auto address                    = detail::IPV4Addr{};
+        address.address.sin_family      = AF_INET;
+        address.address.sin_addr.s_addr = htonl(static_cast<uint32_t>(0x0A000000 + recipient));
+        address.address.sin_port        = htons(static_cast<uint16_t>(20000 + recipient));
+        return address;
+    }
+
+    std::vector<uint8_t> make_update() {
+        auto update = std::vector<uint8_t>(update_size);
+        for (size_t x = 0; x < update.size(); x++) {
+            update[x] = static_cast<uint8_t>(x * 7);
+        }
+        update[0] = 0xFE;
+        return update;
+    }
+
+    // The client side of a broadcast, one update queued on every recipient. Copied is what
+    // a send per recipient does, shared is what ClientRouter::broadcast does
+    void bench_client_queue(bench::State& state, bool shared) {
+        const auto update  = make_update();
+        auto       company = BufferCompany();
+        auto       codecs  = CodecPool();
+        auto       scratch = ScratchPool();
+        auto       socket  = detail::UdpSocket("0");
+
+        auto clients = std::vector<RakroServerClient>(recipients);
+
+        state.set_items_per_iteration(recipients);
+        while (state.keep_running()) {
+            // Fresh clients every time, so the queues dont just keep growing. Replaced one at
+            // a time, freeing all of them at once hands the memory back to the OS and the
+            // timed part ends up measuring page faults
+            state.pause_timing();
+            for (size_t x = 0; x < recipients; x++) {
+                clients[x] = RakroServerClient(
+                    x, nullptr, &socket, 1400, &company, recipient_address(x), 0, &codecs,
+                    PayloadSettings{}, CongestionAlgorithm::SlidingWindow, &scratch
+                );
+            }
+            state.resume_timing();
+
+            if (shared) {
+                const auto body = std::make_shared<const std::vector<uint8_t>>(update);
+                for (auto& client : clients) {
+                    client.send_frame(
+                        body, packets::FrameReliability::ReliableOrdered, SendPriority::Medium
+                    );
+                }
+            } else {
+                for (auto& client : clients) {
+                    client.send_frame(
+                        std::span<const uint8_t>(update),
+                        packets::FrameReliability::ReliableOrdered, SendPriority::Medium
+                    );
+                }
+            }
+            bench::do_not_optimize(clients);
+        }
+    }
+
+    // The game thread side, queueing the update for every recipient and the router taking
+    // it back off the outbox. One message per recipient against one broadcast slot
+    void bench_outbox(bench::State& state, bool shared) {
+        const auto update  = make_update();
+        auto       outbox  = Outbox();
+        auto       handles = std::vector<ClientHandle>(recipients);
+        auto       batch   = std::vector<OutgoingMessage>(recipients);
+
+        for (size_t x = 0; x < recipients; x++) {
+            handles[x] = ClientHandle{.address = recipient_address(x), .guid = x};
+            batch[x]   = OutgoingMessage{.client = handles[x], .payload = update};
+        }
+
+        state.set_items_per_iteration(recipients);
+        while (state.keep_running()) {
+            if (shared) {
+                const auto broadcast = Broadcast{
+                    .body = std::make_shared<const std::vector<uint8_t>>(update)
+                };
+                outbox.push_broadcast(broadcast, false, handles.size(), [&](size_t index) {
+                    return handles[index];
+                });
+            } else {
+                outbox.push(batch);
+            }
+
+            size_t drained = 0;
+            outbox.drain(recipients, [&](const QueuedSend& send) {
+                drained += send.shared != nullptr ? send.recipients.size() : 1;
+            });
+            bench::do_not_optimize(drained);
+        }
+    }
+} // namespace
+
+RAKRO_BENCH(broadcast_1000_client_copied) { bench_client_queue(state, false); }
+RAKRO_BENCH(broadcast_1000_client_shared) { bench_client_queue(state, true); }
+RAKRO_BENCH(broadcast_1000_outbox_copied) { bench_outbox(state, false); }
+RAKRO_BENCH(broadcast_1000_outbox_shared) { bench_outbox(state, true); }
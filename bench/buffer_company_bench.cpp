@@ -0,0 +1,41 @@
+#include "bench.hpp"
+#include <atomic>
+#include <rakro/internal/buffer_company.hpp>
+#include <thread>
+#include <vector>
+
+namespace {
+    using namespace rakro;
+
+    constexpr size_t rents_per_op = 64;
+
+    // Times rent/return on this thread while `contenders` other threads hammer the same
+    // company until we are done
+    void bench_rent(bench::State& state, size_t contenders) {
+        auto company = BufferCompany();
+        auto stop    = std::atomic_bool{false};
+        auto threads = std::vector<std::jthread>();
+
+        for (size_t x = 0; x < contenders; x++) {
+            threads.emplace_back([&] {
+                while (!stop.load(std::memory_order_relaxed)) {
+                    auto buffer = company.rent();
+                    bench::do_not_optimize(buffer);
+                }
+            });
+        }
+
+        state.set_items_per_iteration(rents_per_op);
+        while (state.keep_running()) {
+            for (size_t x = 0; x < rents_per_op; x++) {
+                auto buffer = company.rent();
+                bench::do_not_optimize(buffer);
+            }
+        }
+
+        stop.store(true, std::memory_order_relaxed);
+    }
+} // namespace
+
+RAKRO_BENCH(buffer_company_rent_1_thread) { bench_rent(state, 0); }
+RAKRO_BENCH(buffer_company_rent_4_threads) { bench_rent(state, 3); }
@@ -0,0 +1,85 @@
+#include "bench.hpp"
+#include <rakro/internal/buffer_company.hpp>
+#include <rakro/internal/net.hpp>
+#include <rakro/packet/frame_set.hpp>
+#include <rakro/server/server_client.hpp>
+#include <utility>
+#include <vector>
+
+namespace {
+    using namespace rakro;
+
+    constexpr size_t   datagrams_per_op = 64;
+    constexpr uint16_t body_size        = 32;
+
+    enum class StreamShape { InOrder, Reordered, Lossy };
+
+    // One ReliableOrdered frame per datagram on channel 0, the body is a game packet (0xFE)
+    // so it ends up in the unhandled path and we only measure the reliability layer
+    std::vector<std::vector<uint8_t>> make_stream(StreamShape shape) {
+        auto stream = std::vector<std::vector<uint8_t>>();
+
+        for (uint32_t x = 0; x < datagrams_per_op; x++) {
+            auto datagram = std::vector<uint8_t>(128, 0);
+            auto buffer   = BinaryBuffer(RentedBuffer(datagram, nullptr));
+
+            buffer.write(packets::FrameHeader{.sequence_number = x});
+            buffer.write(packets::FrameInfo{
+                .body_leng         = body_size,
+                .rely              = packets::FrameReliability::ReliableOrdered,
+                .reliability_index = uint24_t(x),
+                .order_info =
+                    packets::FrameInfo::OrderInformation{.order_frame_index = uint24_t(x)}
+            });
+            buffer.write_byte(0xFE);
+            buffer.skipn(body_size - 1);
+
+            datagram.resize(buffer.consumed());
+            stream.push_back(std::move(datagram));
+        }
+
+        if (shape == StreamShape::Reordered) {
+            for (size_t x = 0; x + 1 < stream.size(); x += 2) {
+                std::swap(stream[x], stream[x + 1]);
+            }
+        } else if (shape == StreamShape::Lossy) {
+            std::erase_if(stream, [index = size_t{0}](const auto&) mutable {
+                return ++index % 10 == 0;
+            });
+        }
+
+        return stream;
+    }
+
+    void bench_process_packet(bench::State& state, StreamShape shape) {
+        auto stream  = make_stream(shape);
+        auto company = BufferCompany();
+        auto codecs  = CodecPool();
+        auto scratch = ScratchPool();
+        auto socket  = detail::UdpSocket("0");
+
+        auto address                   = detail::IPV4Addr{};
+        address.address.sin_family      = AF_INET;
+        address.address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        state.set_items_per_iteration(stream.size());
+        while (state.keep_running()) {
+            // A fresh client every time, otherwise the sequence numbers only line up once
+            state.pause_timing();
+            auto client = RakroServerClient(
+                0, nullptr, &socket, 1400, &company, address, 0, &codecs, PayloadSettings{},
+                CongestionAlgorithm::SlidingWindow, &scratch
+            );
+            state.resume_timing();
+
+            for (auto& datagram : stream) {
+                client.process_packet(BinaryBuffer(RentedBuffer(datagram, nullptr)));
+            }
+            bench::do_not_optimize(client);
+        }
+    }
+} // namespace
+
+RAKRO_BENCH(client_process_in_order) { bench_process_packet(state, StreamShape::InOrder); }
+RAKRO_BENCH(client_process_reordered) { bench_process_packet(state, StreamShape::Reordered); }
+RAKRO_BENCH(client_process_lossy) { bench_process_packet(state, StreamShape::Lossy); }
@@ -0,0 +1,68 @@
+#include "bench.hpp"
+#include <array>
+#include <rakro/packet/frame_decoder.hpp>
+#include <rakro/packet/frame_set.hpp>
+#include <vector>
+
+namespace {
+    using namespace rakro;
+
+    constexpr size_t frames_per_set = 16;
+    constexpr size_t frame_body     = 24;
+
+    // The shape most of our traffic has, a frame header and a run of small ReliableOrdered
+    // frames on channel 0
+    struct FrameSetFixture {
+        std::vector<uint8_t> datagram = std::vector<uint8_t>(1400, 0);
+        size_t               length{};
+
+        FrameSetFixture() {
+            auto buffer = BinaryBuffer(RentedBuffer(this->datagram, nullptr));
+            buffer.write(packets::FrameHeader{.sequence_number = 12});
+
+            for (uint32_t x = 0; x < frames_per_set; x++) {
+                buffer.write(packets::FrameInfo{
+                    .body_leng         = frame_body,
+                    .rely              = packets::FrameReliability::ReliableOrdered,
+                    .reliability_index = uint24_t(1000 + x),
+                    .order_info        = packets::FrameInfo::OrderInformation{
+                               .order_frame_index = uint24_t(500 + x), .order_channel = 0
+                    }
+                });
+                buffer.skipn(frame_body);
+            }
+
+            this->length = buffer.consumed();
+        }
+
+        BinaryBuffer view() {
+            return BinaryBuffer(RentedBuffer(this->datagram, nullptr), this->length);
+        }
+    };
+
+    template <typename Reader> void parse_frames(bench::State& state, Reader&& reader) {
+        auto fixture = FrameSetFixture();
+
+        state.set_items_per_iteration(frames_per_set);
+        while (state.keep_running()) {
+            auto buffer = fixture.view();
+            (void)buffer.read_next<packets::FrameHeader>();
+
+            while (buffer.remaining() > 4) {
+                const auto info = reader(buffer);
+                buffer.skipn(info.body_leng);
+                bench::do_not_optimize(info);
+            }
+        }
+    }
+} // namespace
+
+RAKRO_BENCH(frame_parse_generic) {
+    parse_frames(state, [](BinaryBuffer& buffer) {
+        return buffer.read_next<packets::FrameInfo>();
+    });
+}
+
+RAKRO_BENCH(frame_parse_fast_path) {
+    parse_frames(state, [](BinaryBuffer& buffer) { return packets::read_frame_info(buffer); });
+}
@@ -0,0 +1,90 @@
+#include "bench.hpp"
+#include <algorithm>
+#include <array>
+#include <rakro/packet/magic.hpp>
+#include <rakro/packet/packet_id.hpp>
+#include <rakro/server/ingress.hpp>
+#include <utility>
+#include <vector>
+
+namespace {
+    using namespace rakro;
+
+    // A batch shaped like a busy server tick: mostly frame sets, some acks, a couple of
+    // pings and handshakes, and a bit of junk
+    struct IngressFixture {
+        std::vector<std::vector<uint8_t>>                       datagrams{};
+        std::array<std::span<const uint8_t>, MAX_INGRESS_BATCH> views{};
+
+        IngressFixture() {
+            for (size_t x = 0; x < MAX_INGRESS_BATCH; x++) {
+                auto datagram = std::vector<uint8_t>(64, 0);
+
+                switch (x % 16) {
+                case 0: {
+                    datagram[0] = std::to_underlying(PacketId::UnconnectedPing1);
+                    std::ranges::copy(Magic, datagram.begin() + 9);
+                    break;
+                }
+                case 1: {
+                    datagram[0] = std::to_underlying(PacketId::OpenConnectionRequest1);
+                    std::ranges::copy(Magic, datagram.begin() + 1);
+                    break;
+                }
+                case 2:
+                case 3: {
+                    datagram[0] = std::to_underlying(PacketId::Ack);
+                    break;
+                }
+                case 4: {
+                    datagram[0] = 0x42;
+                    break;
+                }
+                default: {
+                    datagram[0] = 0x84;
+                    break;
+                }
+                }
+
+                this->datagrams.push_back(std::move(datagram));
+                this->views[x] = this->datagrams.back();
+            }
+        }
+    };
+} // namespace
+
+RAKRO_BENCH(ingress_classify_batch) {
+    const auto fixture        = IngressFixture();
+    auto       classification = IngressClassification();
+
+    state.set_items_per_iteration(MAX_INGRESS_BATCH);
+    while (state.keep_running()) {
+        classify_ingress(fixture.views, classification);
+        bench::do_not_optimize(classification);
+    }
+}
+
+// Same output as above, one datagram at a time
+RAKRO_BENCH(ingress_classify_scalar) {
+    const auto fixture        = IngressFixture();
+    auto       classification = IngressClassification();
+
+    state.set_items_per_iteration(MAX_INGRESS_BATCH);
+    while (state.keep_running()) {
+        classification.clear();
+        for (size_t x = 0; x < fixture.views.size(); x++) {
+            classification.push(classify_datagram(fixture.views[x]), static_cast<uint8_t>(x));
+        }
+        bench::do_not_optimize(classification);
+    }
+}
+
+RAKRO_BENCH(ingress_offline_magic) {
+    auto datagram = std::array<uint8_t, 32>{};
+    std::ranges::copy(Magic, datagram.begin() + 1);
+
+    while (state.keep_running()) {
+        const auto valid = detail::is_offline_magic(datagram.data() + 1);
+        bench::do_not_optimize(valid);
+    }
+}
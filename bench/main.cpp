@@ -0,0 +1,152 @@
+#include "bench.hpp"
+#include <chrono>
+#include <cstdio>
+#include <print>
+#include <string_view>
+
+namespace {
+    using namespace std::chrono_literals;
+
+    constexpr auto   min_bench_time = 200ms;
+    constexpr size_t max_iterations = size_t{1} << 30;
+
+    enum class OutputFormat { Table, Json, Csv };
+
+    struct Options {
+        OutputFormat     format{OutputFormat::Table};
+        std::string_view filter{};
+    };
+
+    struct Result {
+        const rakro::bench::Benchmark* bench{nullptr};
+        size_t                         iterations{};
+        size_t                         items_per_iteration{};
+        double                         ns_per_op{};
+        double                         ns_per_item{};
+    };
+
+    // Grows the iteration count until a single run takes long enough to trust the clock
+    Result run(const rakro::bench::Benchmark& bench) {
+        size_t iterations = 1;
+
+        while (true) {
+            auto state = rakro::bench::State(iterations);
+            bench.function(state);
+
+            if (state.get_elapsed() < min_bench_time && iterations < max_iterations) {
+                iterations *= 10;
+                continue;
+            }
+
+            const auto total_ns =
+                static_cast<double>(std::chrono::nanoseconds(state.get_elapsed()).count());
+            const auto ns_per_op = total_ns / static_cast<double>(state.get_iterations());
+
+            return Result{
+                .bench               = &bench,
+                .iterations          = state.get_iterations(),
+                .items_per_iteration = state.get_items_per_iteration(),
+                .ns_per_op           = ns_per_op,
+                .ns_per_item =
+                    ns_per_op / static_cast<double>(state.get_items_per_iteration()),
+            };
+        }
+    }
+
+    void print_header(OutputFormat format) {
+        switch (format) {
+        case OutputFormat::Table: {
+            std::println(
+                "{:<40} {:>12} {:>14} {:>14}", "benchmark", "iterations", "ns/op", "ns/item"
+            );
+            break;
+        }
+        case OutputFormat::Json: {
+            std::println("{{\"schema\": 1, \"benchmarks\": [");
+            break;
+        }
+        case OutputFormat::Csv: {
+            std::println("name,iterations,items_per_op,ns_per_op,ns_per_item");
+            break;
+        }
+        }
+    }
+
+    void print_result(OutputFormat format, const Result& result, bool first) {
+        switch (format) {
+        case OutputFormat::Table: {
+            std::println(
+                "{:<40} {:>12} {:>14.2f} {:>14.2f}", result.bench->name, result.iterations,
+                result.ns_per_op, result.ns_per_item
+            );
+            break;
+        }
+        case OutputFormat::Json: {
+            // Names are C identifiers from RAKRO_BENCH, so they never need escaping
+            std::println(
+                "{}  {{\"name\": \"{}\", \"iterations\": {}, \"items_per_op\": {}, "
+                "\"ns_per_op\": {:.3f}, \"ns_per_item\": {:.3f}}}",
+                first ? "" : ",", result.bench->name, result.iterations,
+                result.items_per_iteration, result.ns_per_op, result.ns_per_item
+            );
+            break;
+        }
+        case OutputFormat::Csv: {
+            std::println(
+                "{},{},{},{:.3f},{:.3f}", result.bench->name, result.iterations,
+                result.items_per_iteration, result.ns_per_op, result.ns_per_item
+            );
+            break;
+        }
+        }
+
+        std::fflush(stdout);
+    }
+
+    void print_footer(OutputFormat format) {
+        if (format == OutputFormat::Json) {
+            std::println("]}}");
+        }
+    }
+
+    Options parse_options(int argc, char** argv) {
+        Options options{};
+
+        for (int x = 1; x < argc; x++) {
+            const auto arg = std::string_view(argv[x]);
+
+            if (arg == "--json") {
+                options.format = OutputFormat::Json;
+            } else if (arg == "--csv") {
+                options.format = OutputFormat::Csv;
+            } else {
+                options.filter = arg;
+            }
+        }
+
+        return options;
+    }
+} // namespace
+
+// Usage: rakro_bench [--json | --csv] [name filter]
+//
+// The table is for people, --json and --csv are stable and meant to be diffed between
+// releases. Timings are always nanoseconds, ns/item divides by whatever the benchmark counts
+// as one item (a datagram, a frame, a record...)
+int main(int argc, char** argv) {
+    const auto options = parse_options(argc, argv);
+
+    print_header(options.format);
+
+    bool first = true;
+    for (const auto& bench : rakro::bench::registry()) {
+        if (!options.filter.empty() && !bench.name.contains(options.filter)) {
+            continue;
+        }
+
+        print_result(options.format, run(bench), first);
+        first = false;
+    }
+
+    print_footer(options.format);
+}
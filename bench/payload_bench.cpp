@@ -0,0 +1,65 @@
+#include "bench.hpp"
+#include <rakro/server/payload_pipeline.hpp>
+#include <span>
+#include <vector>
+
+namespace {
+    using namespace rakro;
+
+    constexpr size_t packets_per_batch = 16;
+
+    // Movement-ish packets, small and fairly repetitive
+    struct BatchFixture {
+        std::vector<std::vector<uint8_t>>     packets{};
+        std::vector<std::span<const uint8_t>> views{};
+
+        BatchFixture() {
+            for (size_t x = 0; x < packets_per_batch; x++) {
+                auto packet = std::vector<uint8_t>(48 + x * 4);
+                for (size_t y = 0; y < packet.size(); y++) {
+                    packet[y] = static_cast<uint8_t>((x * 31 + y / 3) & 0x3F);
+                }
+                this->packets.push_back(std::move(packet));
+            }
+            this->views.assign(this->packets.begin(), this->packets.end());
+        }
+    };
+
+    constexpr auto compressed_settings =
+        PayloadSettings{.enabled = true, .compressed = true, .threshold = 0, .level = 7};
+} // namespace
+
+RAKRO_BENCH(payload_encode_deflate) {
+    const auto fixture  = BatchFixture();
+    auto       codecs   = CodecPool();
+    auto       pipeline = PayloadPipeline(&codecs, compressed_settings);
+    auto       memory   = std::vector<uint8_t>(4096);
+
+    state.set_items_per_iteration(packets_per_batch);
+    while (state.keep_running()) {
+        auto buffer = BinaryBuffer(RentedBuffer(memory, nullptr));
+        bench::do_not_optimize(pipeline.encode(fixture.views, buffer));
+    }
+}
+
+RAKRO_BENCH(payload_decode_deflate) {
+    const auto fixture  = BatchFixture();
+    auto       codecs   = CodecPool();
+    auto       pipeline = PayloadPipeline(&codecs, compressed_settings);
+    auto       memory   = std::vector<uint8_t>(4096);
+    auto       buffer   = BinaryBuffer(RentedBuffer(memory, nullptr));
+    pipeline.encode(fixture.views, buffer);
+
+    // Skip the 0xFE, decode wants whatever follows the id
+    const auto batch = std::span(memory).subspan(1, buffer.consumed() - 1);
+
+    state.set_items_per_iteration(packets_per_batch);
+    while (state.keep_running()) {
+        const auto decoded = pipeline.decode(batch);
+        size_t     bytes   = 0;
+        for (const auto packet : decoded->packets()) {
+            bytes += packet.size();
+        }
+        bench::do_not_optimize(bytes);
+    }
+}
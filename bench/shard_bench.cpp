@@ -0,0 +1,122 @@
+#include "bench.hpp"
+#include <atomic>
+#include <rakro/internal/buffer_company.hpp>
+#include <rakro/internal/net.hpp>
+#include <rakro/internal/spsc_queue.hpp>
+#include <rakro/packet/frame_set.hpp>
+#include <rakro/server/shards.hpp>
+#include <thread>
+#include <vector>
+
+namespace {
+    using namespace rakro;
+
+    constexpr size_t   items_per_op     = 1024;
+    constexpr size_t   clients          = 256;
+    constexpr size_t   datagrams_per_op = 512; // Stays under the queue capacity per worker
+    constexpr uint16_t body_size        = 32;
+
+    // One producer, one consumer on another thread, items go through as fast as they can
+    void bench_spsc_handoff(bench::State& state) {
+        auto queue = SpscQueue<uint64_t>(1024);
+        auto total = std::atomic<uint64_t>{0};
+        auto stop  = std::atomic_bool{false};
+
+        auto consumer = std::jthread([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                while (const auto value = queue.try_pop()) {
+                    total.fetch_add(1, std::memory_order_relaxed);
+                    bench::do_not_optimize(*value);
+                }
+            }
+        });
+
+        uint64_t pushed = 0;
+
+        state.set_items_per_iteration(items_per_op);
+        while (state.keep_running()) {
+            for (size_t x = 0; x < items_per_op; x++) {
+                while (!queue.try_push(uint64_t{x})) {
+                }
+            }
+            pushed += items_per_op;
+        }
+
+        while (total.load(std::memory_order_relaxed) != pushed) {
+        }
+        stop.store(true, std::memory_order_relaxed);
+    }
+
+    detail::IPV4Addr client_address(size_t client) {
+        auto address                    = detail::IPV4Addr{};
+        address.address.sin_family      = AF_INET;
+        address.address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.address.sin_port        = htons(static_cast<uint16_t>(20000 + client));
+        return address;
+    }
+
+    // The listener side of a server with `workers` threads, every client gets one reliable
+    // frame per datagram and the op only ends once the workers got through all of them, so
+    // this scales with the workers as long as the listener keeps up
+    void bench_sharded_route(bench::State& state, size_t workers) {
+        auto company = BufferCompany(512, 2048, 8);
+        auto codecs  = CodecPool();
+        auto scratch = ScratchPool();
+        auto socket  = detail::UdpSocket("0");
+        auto router  = ShardedRouter(workers, 10, 1024);
+
+        const auto settings = ClientSettings{
+            .socket = &socket, .company = &company, .codecs = &codecs, .scratch = &scratch
+        };
+
+        for (size_t client = 0; client < clients; client++) {
+            const auto semi = SemiConnectedClient{.mtu = 1400};
+            router.connect(client_address(client), semi, 0, settings);
+        }
+        router.wake();
+
+        auto     sequences = std::vector<uint32_t>(clients, 0);
+        uint64_t expected  = clients;
+
+        state.set_items_per_iteration(datagrams_per_op);
+        while (state.keep_running()) {
+            for (size_t x = 0; x < datagrams_per_op; x++) {
+                const auto client   = x % clients;
+                const auto sequence = sequences[client]++;
+
+                auto rented = company.rent();
+                auto writer = BinaryBuffer(RentedBuffer(rented.get_memory(), nullptr));
+
+                writer.write(packets::FrameHeader{.sequence_number = sequence});
+                writer.write(packets::FrameInfo{
+                    .body_leng         = body_size,
+                    .rely              = packets::FrameReliability::Reliable,
+                    .reliability_index = uint24_t(sequence)
+                });
+                writer.write_byte(0xFE);
+                writer.skipn(body_size - 1);
+
+                router.route(
+                    client_address(client), BinaryBuffer(std::move(rented), writer.consumed())
+                );
+            }
+            router.wake();
+
+            expected += datagrams_per_op;
+            while (true) {
+                const auto stats = router.get_stats();
+                if (stats.handled + stats.dropped >= expected) {
+                    break;
+                }
+                std::this_thread::yield();
+            }
+        }
+    }
+} // namespace
+
+RAKRO_BENCH(spsc_queue_handoff) { bench_spsc_handoff(state); }
+RAKRO_BENCH(sharded_route_inline) { bench_sharded_route(state, 0); }
+RAKRO_BENCH(sharded_route_1_worker) { bench_sharded_route(state, 1); }
+RAKRO_BENCH(sharded_route_2_workers) { bench_sharded_route(state, 2); }
+RAKRO_BENCH(sharded_route_4_workers) { bench_sharded_route(state, 4); }
+RAKRO_BENCH(sharded_route_8_workers) { bench_sharded_route(state, 8); }
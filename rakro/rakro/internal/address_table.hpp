@@ -0,0 +1,180 @@
+#pragma once
+
+#include "rakro/internal/net.hpp"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace rakro {
+
+    // Flat hash table from an address to a T, for lookups on every received datagram. The
+    // table itself is one array of 16 byte entries, the packed address and the index of the
+    // slot the value lives in, probed linearly. Erasing shifts the entries after it back, so
+    // there are no tombstones and a miss stops at the first empty entry.
+    //
+    // Values live in fixed size chunks that never move, a T found here stays where it is
+    // until it is erased, no matter what gets inserted meanwhile
+    template <typename T> class AddressTable {
+    public:
+        AddressTable() { this->entries.resize(MIN_CAPACITY); }
+        AddressTable(const AddressTable&) = delete;
+
+        T* find(const detail::IPV4Addr& address) noexcept {
+            const auto* entry = this->lookup(address.packed());
+            return entry != nullptr ? &this->slot(entry->slot) : nullptr;
+        }
+
+        bool contains(const detail::IPV4Addr& address) const noexcept {
+            return this->lookup(address.packed()) != nullptr;
+        }
+
+        // Returns the value already there and false, or the new one and true
+        std::pair<T*, bool> insert(const detail::IPV4Addr& address, T&& value) {
+            if ((this->count + 1) * 2 > this->entries.size()) {
+                this->grow();
+            }
+
+            const auto key = address.packed();
+
+            auto index = this->home(key);
+            for (; this->entries[index].key != EMPTY; index = (index + 1) & this->mask()) {
+                if (this->entries[index].key == key) {
+                    return {&this->slot(this->entries[index].slot), false};
+                }
+            }
+
+            const auto value_slot = this->allocate();
+            this->slot(value_slot) = std::move(value);
+
+            this->entries[index] = {.key = key, .slot = value_slot};
+            this->count++;
+
+            return {&this->slot(value_slot), true};
+        }
+
+        bool erase(const detail::IPV4Addr& address) {
+            const auto key = address.packed();
+
+            auto index = this->home(key);
+            for (; this->entries[index].key != key; index = (index + 1) & this->mask()) {
+                if (this->entries[index].key == EMPTY) {
+                    return false;
+                }
+            }
+
+            // Reset right away, so whatever the value owns is released now
+            this->release(this->entries[index].slot);
+            this->count--;
+
+            // Pulls back every entry after it that would otherwise be cut off from its home
+            auto hole = index;
+            auto next = (hole + 1) & this->mask();
+
+            while (this->entries[next].key != EMPTY) {
+                const auto ideal = this->home(this->entries[next].key);
+
+                if (((next - ideal) & this->mask()) >= ((next - hole) & this->mask())) {
+                    this->entries[hole] = this->entries[next];
+                    hole                = next;
+                }
+                next = (next + 1) & this->mask();
+            }
+            this->entries[hole] = Entry();
+
+            return true;
+        }
+
+        // Calls fn(value) for every value, in no particular order. fn mustnt insert or erase
+        template <typename Fn> void for_each(Fn&& fn) {
+            for (const auto& entry : this->entries) {
+                if (entry.key != EMPTY) {
+                    fn(this->slot(entry.slot));
+                }
+            }
+        }
+
+        size_t size() const noexcept { return this->count; }
+
+    private:
+        static constexpr uint64_t EMPTY        = std::numeric_limits<uint64_t>::max();
+        static constexpr size_t   MIN_CAPACITY = 64;
+        static constexpr size_t   CHUNK_BITS   = 6;
+        static constexpr size_t   CHUNK_SIZE   = size_t{1} << CHUNK_BITS;
+
+        struct Entry {
+            uint64_t key{EMPTY}; // Addresses only use 48 bits, so this is never a real one
+            uint32_t slot{0};
+        };
+
+        const Entry* lookup(uint64_t key) const noexcept {
+            for (auto index = this->home(key);; index = (index + 1) & this->mask()) {
+                const auto& entry = this->entries[index];
+
+                if (entry.key == key) {
+                    return &entry;
+                }
+                if (entry.key == EMPTY) {
+                    return nullptr;
+                }
+            }
+        }
+
+        size_t mask() const noexcept { return this->entries.size() - 1; }
+
+        // Fibonacci hashing, the multiply mixes the port into the bits the index is taken from
+        size_t home(uint64_t key) const noexcept {
+            const auto shift = 64 - std::countr_zero(this->entries.size());
+            return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift);
+        }
+
+        T& slot(uint32_t index) noexcept {
+            return this->chunks[index >> CHUNK_BITS][index & (CHUNK_SIZE - 1)];
+        }
+
+        uint32_t allocate() {
+            if (!this->free_slots.empty()) {
+                const auto slot = this->free_slots.back();
+                this->free_slots.pop_back();
+                return slot;
+            }
+
+            if (this->used_slots % CHUNK_SIZE == 0) {
+                this->chunks.push_back(std::make_unique<T[]>(CHUNK_SIZE));
+            }
+            return static_cast<uint32_t>(this->used_slots++);
+        }
+
+        void release(uint32_t index) {
+            this->slot(index) = T();
+            this->free_slots.push_back(index);
+        }
+
+        void grow() {
+            const auto capacity = this->entries.size() * 2;
+            const auto old      = std::exchange(this->entries, std::vector<Entry>(capacity));
+
+            for (const auto& entry : old) {
+                if (entry.key == EMPTY) {
+                    continue;
+                }
+
+                auto index = this->home(entry.key);
+                while (this->entries[index].key != EMPTY) {
+                    index = (index + 1) & this->mask();
+                }
+                this->entries[index] = entry;
+            }
+        }
+
+    private:
+        std::vector<Entry>                entries{};
+        std::vector<std::unique_ptr<T[]>> chunks{};
+        std::vector<uint32_t>             free_slots{};
+        size_t                            used_slots{0};
+        size_t                            count{0};
+    };
+} // namespace rakro
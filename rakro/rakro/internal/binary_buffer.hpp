@@ -50,6 +50,7 @@ namespace rakro {
             if (this != &other) {
                 real_buffer = std::move(other.real_buffer);
                 bytes       = std::move(other.bytes);
+                index       = std::exchange(other.index, 0);
             }
             return *this;
         }
@@ -162,8 +163,9 @@ namespace rakro {
                                                                                                \
             static type read(BinaryBuffer& buffer) {                                           \
                 type value{};                                                                  \
+                /* Widened first, 64 bit values lost their top half otherwise */               \
                 for (size_t x = 0; x < sizeof(type); x++)                                      \
-                    value |= static_cast<type>((buffer.next_byte() << x * 8));                 \
+                    value |= static_cast<type>(type(buffer.next_byte()) << x * 8);             \
                 return std::byteswap(value);                                                   \
             }                                                                                  \
                                                                                                \
@@ -185,10 +187,10 @@ INTEGRAL_BINARY(bool);
 namespace rakro {
     template <> struct BinaryDataInterface<uint24_t> {
         static void write(const uint24_t& val, BinaryBuffer& buffer) {
-            auto bytes = std::bit_cast<std::array<uint8_t, sizeof(uint24_t)>>(val);
+            const auto value = val.get_value();
 
-            for (size_t x = 1; x < 4; x++) {
-                buffer.write_byte(bytes[x]);
+            for (size_t x = 0; x < 3; x++) {
+                buffer.write_byte(static_cast<uint8_t>(value >> (x * 8)));
             }
         }
 
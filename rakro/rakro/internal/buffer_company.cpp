@@ -40,21 +40,21 @@ namespace rakro {
         this->waiter.notify_one();
     }
 
-    RentedBuffer BufferCompany::rent() noexcept {
-        const auto try_all = [&] -> std::optional<RentedBuffer> {
-            auto lock = std::shared_lock(this->blocks_mutex);
-            for (auto& block : this->blocks) {
-                auto return_value = block.try_rent();
+    std::optional<RentedBuffer> BufferCompany::try_blocks() noexcept {
+        auto lock = std::shared_lock(this->blocks_mutex);
+        for (auto& block : this->blocks) {
+            auto return_value = block.try_rent();
 
-                if (return_value.has_value()) {
-                    return std::move(return_value.value());
-                }
+            if (return_value.has_value()) {
+                return std::move(return_value.value());
             }
+        }
 
-            return std::nullopt;
-        };
+        return std::nullopt;
+    }
 
-        auto val = try_all();
+    RentedBuffer BufferCompany::rent() noexcept {
+        auto val = this->try_blocks();
         if (val.has_value()) {
             return std::move(val.value());
         }
@@ -65,7 +65,33 @@ namespace rakro {
 
         this->init_block();
 
-        return std::move(try_all().value());
+        return std::move(this->try_blocks().value());
+    }
+
+    std::optional<RentedBuffer> BufferCompany::try_rent(size_t reserve) noexcept {
+        {
+            auto lock = std::shared_lock(this->blocks_mutex);
+
+            // Only a snapshot, other threads rent and return while we count
+            auto free = (this->block_max_count - this->blocks.size()) * this->buffer_count;
+            for (const auto& block : this->blocks) {
+                free += block.free_buffer_count.load(std::memory_order_relaxed);
+            }
+
+            if (free <= reserve) {
+                return std::nullopt;
+            }
+        }
+
+        auto val = this->try_blocks();
+        if (val.has_value() || this->blocks.size() >= this->block_max_count) {
+            return val;
+        }
+
+        if (!this->init_block()) {
+            return std::nullopt;
+        }
+        return this->try_blocks();
     }
 
     RentedBuffer BufferBlock::rent() noexcept {
@@ -99,7 +125,8 @@ namespace rakro {
     BufferBlock::BufferBlock(size_t buffer_size, size_t buffer_count) {
         this->free_buffer_count = buffer_count;
 
-        uint8_t* memory = new uint8_t[buffer_size * buffer_count];
+        uint8_t* memory    = new uint8_t[buffer_size * buffer_count];
+        this->block_memory = memory;
 
         for (size_t start = 0; start < this->free_buffer_count; start++) {
             // Pointer math, BooOooOo scary
@@ -111,4 +138,16 @@ namespace rakro {
             this->free_buffers.emplace(std::move(buff));
         }
     }
-} // namespace rakro
\ No newline at end of file
+
+    BufferBlock::~BufferBlock() noexcept {
+        // Everything on the free list would hand itself straight back to us while the list
+        // is being torn down, so cut them loose first
+        while (!this->free_buffers.empty()) {
+            auto buffer = std::move(this->free_buffers.top());
+            this->free_buffers.pop();
+            buffer.owner = nullptr;
+        }
+
+        delete[] this->block_memory;
+    }
+} // namespace rakro
@@ -47,6 +47,8 @@ namespace rakro {
     private:
         std::span<uint8_t>  memory{};
         struct BufferBlock* owner{nullptr};
+
+        friend struct BufferBlock;
     };
 
     struct BufferBlock {
@@ -57,6 +59,8 @@ namespace rakro {
         std::atomic_size_t       free_buffer_count{};
 
         BufferBlock(size_t buffer_size, size_t buffer_count);
+        BufferBlock(const BufferBlock&) = delete;
+        ~BufferBlock() noexcept;
 
         void add_free(RentedBuffer buffer) noexcept;
 
@@ -77,8 +81,18 @@ namespace rakro {
 
         RentedBuffer rent() noexcept;
 
+        // Never sleeps. Fails instead of leaving fewer than reserve buffers for everyone
+        // else, blocks that arent made yet count as free
+        std::optional<RentedBuffer> try_rent(size_t reserve = 0) noexcept;
+
+        // Every buffer there can be once all blocks are made
+        size_t get_capacity() const noexcept {
+            return this->buffer_count * this->block_max_count;
+        }
+
     private:
         bool init_block();
+        std::optional<RentedBuffer> try_blocks() noexcept;
 
     private:
         size_t                 buffer_count{512};
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <limits>
+#include <rakro/internal/codec_pool.hpp>
+
+#ifdef RAKRO_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+namespace rakro {
+
+#ifdef RAKRO_HAS_ZLIB
+    // Bedrock uses raw deflate, no zlib header or checksum
+    constexpr int RAW_DEFLATE_WINDOW = -15;
+
+    struct CodecContext::Streams {
+        z_stream inflater{};
+        z_stream deflater{};
+        bool     inflater_ready{false};
+        bool     deflater_ready{false};
+        int      deflate_level{Z_DEFAULT_COMPRESSION};
+
+        ~Streams() {
+            if (this->inflater_ready) {
+                inflateEnd(&this->inflater);
+            }
+            if (this->deflater_ready) {
+                deflateEnd(&this->deflater);
+            }
+        }
+    };
+#else
+    struct CodecContext::Streams {};
+#endif
+
+    CodecContext::CodecContext() : streams(std::make_unique<Streams>()) {}
+    CodecContext::~CodecContext() = default;
+
+    bool CodecContext::has_deflate() noexcept {
+#ifdef RAKRO_HAS_ZLIB
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    std::optional<std::span<uint8_t>>
+    CodecContext::inflate(std::span<const uint8_t> input, size_t max_size) {
+#ifdef RAKRO_HAS_ZLIB
+        auto& stream = this->streams->inflater;
+
+        if (!this->streams->inflater_ready) {
+            if (inflateInit2(&stream, RAW_DEFLATE_WINDOW) != Z_OK) {
+                return std::nullopt;
+            }
+            this->streams->inflater_ready = true;
+        } else if (inflateReset(&stream) != Z_OK) {
+            return std::nullopt;
+        }
+
+        // Game packets usually inflate to a few times their size, start there and grow
+        if (this->scratch.size() < input.size() * 4) {
+            this->scratch.resize(std::min(input.size() * 4, max_size));
+        }
+
+        stream.next_in  = const_cast<Bytef*>(input.data());
+        stream.avail_in = static_cast<uInt>(input.size());
+
+        size_t produced = 0;
+
+        while (true) {
+            if (produced == this->scratch.size()) {
+                if (this->scratch.size() >= max_size) {
+                    return std::nullopt; // Either broken or a zip bomb, drop it either way
+                }
+
+                const auto grown = std::max(this->scratch.size() * 2, size_t{256});
+                this->scratch.resize(std::min(grown, max_size));
+            }
+
+            const auto space = std::min(
+                this->scratch.size() - produced, size_t{std::numeric_limits<uInt>::max()}
+            );
+
+            stream.next_out  = this->scratch.data() + produced;
+            stream.avail_out = static_cast<uInt>(space);
+
+            const auto result = ::inflate(&stream, Z_NO_FLUSH);
+            produced += space - stream.avail_out;
+
+            if (result == Z_STREAM_END) {
+                return std::span(this->scratch).subspan(0, produced);
+            }
+
+            if (result != Z_OK && result != Z_BUF_ERROR) {
+                return std::nullopt;
+            }
+
+            // Output space left over but no end of stream means the input was cut short
+            if (stream.avail_out != 0) {
+                return std::nullopt;
+            }
+        }
+#else
+        return std::nullopt;
+#endif
+    }
+
+    std::optional<size_t>
+    CodecContext::deflate(std::span<const uint8_t> input, std::span<uint8_t> out, int level) {
+#ifdef RAKRO_HAS_ZLIB
+        auto& stream = this->streams->deflater;
+
+        if (!this->streams->deflater_ready) {
+            if (deflateInit2(
+                    &stream, level, Z_DEFLATED, RAW_DEFLATE_WINDOW, 8, Z_DEFAULT_STRATEGY
+                ) != Z_OK) {
+                return std::nullopt;
+            }
+            this->streams->deflater_ready = true;
+            this->streams->deflate_level  = level;
+        } else {
+            if (deflateReset(&stream) != Z_OK) {
+                return std::nullopt;
+            }
+
+            // Only costs anything when the level actually changes, on a freshly reset stream
+            // it just swaps the config over
+            if (this->streams->deflate_level != level) {
+                if (deflateParams(&stream, level, Z_DEFAULT_STRATEGY) != Z_OK) {
+                    return std::nullopt;
+                }
+                this->streams->deflate_level = level;
+            }
+        }
+
+        stream.next_in   = const_cast<Bytef*>(input.data());
+        stream.avail_in  = static_cast<uInt>(input.size());
+        stream.next_out  = out.data();
+        stream.avail_out = static_cast<uInt>(out.size());
+
+        if (::deflate(&stream, Z_FINISH) != Z_STREAM_END) {
+            return std::nullopt; // Ran out of room in out
+        }
+
+        return out.size() - stream.avail_out;
+#else
+        return std::nullopt;
+#endif
+    }
+
+    void CodecContext::trim(size_t max_retained) noexcept {
+        if (this->scratch.capacity() > max_retained) {
+            this->scratch = {};
+        }
+    }
+
+    void RentedCodec::give_back() noexcept {
+        if (this->context && this->owner) {
+            this->owner->give_back(std::move(this->context));
+        }
+        this->owner = nullptr;
+    }
+
+    RentedCodec CodecPool::rent() {
+        {
+            const auto lock = std::unique_lock(this->free_mutex);
+
+            if (!this->free_contexts.empty()) {
+                auto context = std::move(this->free_contexts.back());
+                this->free_contexts.pop_back();
+                return RentedCodec(std::move(context), this);
+            }
+        }
+
+        return RentedCodec(std::make_unique<CodecContext>(), this);
+    }
+
+    void CodecPool::give_back(std::unique_ptr<CodecContext> context) noexcept {
+        context->trim(this->max_retained_scratch);
+
+        const auto lock = std::unique_lock(this->free_mutex);
+        this->free_contexts.push_back(std::move(context));
+    }
+} // namespace rakro
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace rakro {
+
+    // A pair of deflate streams plus a scratch buffer. Setting a zlib stream up allocates a
+    // few hundred KB, so contexts are made once, kept in a CodecPool and only reset between
+    // batches
+    class CodecContext {
+    public:
+        CodecContext();
+        CodecContext(const CodecContext&) = delete;
+        ~CodecContext();
+
+        // False when rakro was built without zlib, every deflate call fails in that case
+        static bool has_deflate() noexcept;
+
+        // Inflates raw deflate data into the scratch buffer, nullopt if the data is broken
+        // or inflates to more than max_size bytes
+        std::optional<std::span<uint8_t>>
+        inflate(std::span<const uint8_t> input, size_t max_size);
+
+        // Deflates into out, nullopt if the data doesnt fit
+        std::optional<size_t>
+        deflate(std::span<const uint8_t> input, std::span<uint8_t> out, int level);
+
+        // Free space to build a batch in before compressing it, grows as needed and keeps its
+        // memory between rents
+        std::vector<uint8_t>& get_scratch() noexcept { return this->scratch; }
+
+        // Drops scratch memory that a single huge batch left behind
+        void trim(size_t max_retained) noexcept;
+
+    private:
+        struct Streams;
+
+        std::unique_ptr<Streams> streams{};
+        std::vector<uint8_t>     scratch{};
+    };
+
+    class CodecPool;
+
+    class RentedCodec {
+    public:
+        RentedCodec() = default;
+        RentedCodec(std::unique_ptr<CodecContext> context, CodecPool* owner)
+            : context(std::move(context)), owner(owner) {}
+        RentedCodec(RentedCodec&&) = default;
+        RentedCodec& operator=(RentedCodec&& other) noexcept {
+            if (this != &other) {
+                this->give_back();
+                this->context = std::move(other.context);
+                this->owner   = std::exchange(other.owner, nullptr);
+            }
+            return *this;
+        }
+        ~RentedCodec() noexcept { this->give_back(); }
+
+        CodecContext* operator->() noexcept { return this->context.get(); }
+        CodecContext& operator*() noexcept { return *this->context; }
+
+        explicit operator bool() const noexcept { return this->context != nullptr; }
+
+    private:
+        void give_back() noexcept;
+
+    private:
+        std::unique_ptr<CodecContext> context{};
+        CodecPool*                    owner{nullptr};
+    };
+
+    // Shared by every connection, contexts are only ever held for one batch so a handful is
+    // enough even with a lot of clients
+    class CodecPool {
+    public:
+        explicit CodecPool(size_t max_retained_scratch = size_t{1} << 20)
+            : max_retained_scratch(max_retained_scratch) {}
+        CodecPool(const CodecPool&) = delete;
+
+        RentedCodec rent();
+
+    private:
+        void give_back(std::unique_ptr<CodecContext> context) noexcept;
+
+    private:
+        size_t                                     max_retained_scratch{};
+        std::mutex                                 free_mutex{};
+        std::vector<std::unique_ptr<CodecContext>> free_contexts{};
+
+        friend class RentedCodec;
+    };
+} // namespace rakro
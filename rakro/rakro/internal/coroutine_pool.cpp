@@ -0,0 +1,56 @@
+#include <new>
+#include <rakro/internal/coroutine_pool.hpp>
+
+namespace rakro {
+
+    CoroutineFramePool::~CoroutineFramePool() {
+        for (size_t index = 0; index < CLASS_COUNT; index++) {
+            auto* frame = this->classes[index].head;
+
+            while (frame != nullptr) {
+                auto* next = frame->next;
+                ::operator delete(frame, (index + 1) * CLASS_SIZE);
+                frame = next;
+            }
+        }
+    }
+
+    CoroutineFramePool& CoroutineFramePool::local() noexcept {
+        thread_local auto pool = CoroutineFramePool();
+        return pool;
+    }
+
+    void* CoroutineFramePool::allocate(size_t size) {
+        const auto index = (size + CLASS_SIZE - 1) / CLASS_SIZE - 1;
+        if (size == 0 || index >= CLASS_COUNT) {
+            return ::operator new(size);
+        }
+
+        auto& size_class = this->classes[index];
+        if (size_class.head == nullptr) {
+            return ::operator new((index + 1) * CLASS_SIZE);
+        }
+
+        auto* frame     = size_class.head;
+        size_class.head = frame->next;
+        size_class.count--;
+        return frame;
+    }
+
+    void CoroutineFramePool::deallocate(void* frame, size_t size) noexcept {
+        const auto index = (size + CLASS_SIZE - 1) / CLASS_SIZE - 1;
+        if (size == 0 || index >= CLASS_COUNT) {
+            ::operator delete(frame, size);
+            return;
+        }
+
+        auto& size_class = this->classes[index];
+        if (size_class.count >= MAX_FREE_PER_CLASS) {
+            ::operator delete(frame, (index + 1) * CLASS_SIZE);
+            return;
+        }
+
+        size_class.head = new (frame) FreeFrame{.next = size_class.head};
+        size_class.count++;
+    }
+} // namespace rakro
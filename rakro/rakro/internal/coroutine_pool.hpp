@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace rakro {
+
+    // Where coroutine frames come from, one pool per thread so nothing is locked. Frames are
+    // rounded up to 64 byte size classes and kept on a free list per class once freed, so a
+    // session that ends hands its frame straight to the next one. Anything past the biggest
+    // class goes to operator new.
+    //
+    // A frame freed on another thread than it came from just ends up in that thread's pool
+    class CoroutineFramePool {
+    public:
+        CoroutineFramePool() = default;
+        CoroutineFramePool(const CoroutineFramePool&) = delete;
+        ~CoroutineFramePool();
+
+        static CoroutineFramePool& local() noexcept;
+
+        void* allocate(size_t size);
+        void  deallocate(void* frame, size_t size) noexcept;
+
+    private:
+        static constexpr size_t CLASS_SIZE  = 64;
+        static constexpr size_t CLASS_COUNT = 64; // Up to 4 KiB
+        // Frames kept per class, the rest are freed
+        static constexpr size_t MAX_FREE_PER_CLASS = 1024;
+
+        struct FreeFrame {
+            FreeFrame* next{nullptr};
+        };
+
+        struct SizeClass {
+            FreeFrame* head{nullptr};
+            size_t     count{0};
+        };
+
+    private:
+        std::array<SizeClass, CLASS_COUNT> classes{};
+    };
+} // namespace rakro
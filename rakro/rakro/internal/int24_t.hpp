@@ -8,7 +8,16 @@ namespace rakro {
     class uint24_t {
     public:
         constexpr uint24_t() : value(0) {}
-        constexpr uint24_t(uint32_t v) : value(v) {}
+        // Masked so arithmetic wraps at 2^24 and equal values hash the same
+        constexpr uint24_t(uint32_t v) : value(v & mask) {}
+
+        // Reads 3 little endian bytes, the caller has to have bounds checked data
+        static constexpr uint24_t from_le_bytes(const uint8_t* data) noexcept {
+            return uint24_t(
+                static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+                (static_cast<uint32_t>(data[2]) << 16)
+            );
+        }
 
         constexpr uint32_t get_value() const { return value; }
         constexpr void     set_value(uint32_t v) { value = v & mask; }
@@ -159,6 +168,13 @@ namespace rakro {
         uint32_t                  value;
         constexpr static uint32_t mask = 0x00FFFFFF;
     };
+
+    // Signed distance from rhs to lhs, wrapping around at 2^24. Sequence numbers, reliable
+    // and order indices all wrap, so this is how they have to be compared
+    constexpr int32_t sequence_delta(uint24_t lhs, uint24_t rhs) noexcept {
+        const auto difference = (lhs - rhs).get_value();
+        return static_cast<int32_t>(difference << 8) >> 8;
+    }
 } // namespace rakro
 
 namespace std {
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "rakro/internal/spsc_queue.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+
+namespace rakro {
+
+    // Bounded lock free queue for any number of producer threads and one consumer thread.
+    // Producers claim a run of slots with one CAS on the tail, fill them in place and mark
+    // each one ready. The consumer handles slots in place too and leaves whatever they own
+    // where it is, so a slot holding a vector keeps its capacity for the next lap.
+    //
+    // A producer that claimed slots and hasnt marked them yet holds the consumer up at the
+    // first one, nothing after it is handed out before it
+    template <typename T> class MpscQueue {
+    public:
+        explicit MpscQueue(size_t capacity)
+            : slots(std::make_unique<Slot[]>(std::bit_ceil(std::max(capacity, size_t{2})))),
+              mask(std::bit_ceil(std::max(capacity, size_t{2})) - 1) {}
+        MpscQueue(const MpscQueue&) = delete;
+
+        // Any thread. Claims up to count slots in one go and calls fill(slot, i) for each of
+        // them, returns how many were claimed. Less than count means the queue is full
+        template <typename Fill> size_t try_push_bulk(size_t count, Fill&& fill) {
+            auto tail  = this->tail.load(std::memory_order_relaxed);
+            auto claim = size_t{0};
+
+            do {
+                const auto head = this->head.load(std::memory_order_acquire);
+                claim           = std::min(count, this->mask + 1 - (tail - head));
+                if (claim == 0) {
+                    return 0;
+                }
+            } while (!this->tail.compare_exchange_weak(
+                tail, tail + claim, std::memory_order_relaxed, std::memory_order_relaxed
+            ));
+
+            for (size_t index = 0; index < claim; index++) {
+                auto& slot = this->slots[(tail + index) & this->mask];
+                fill(slot.value, index);
+                slot.ready.store(tail + index + 1, std::memory_order_release);
+            }
+            return claim;
+        }
+
+        template <typename Fill> bool try_push(Fill&& fill) {
+            return this->try_push_bulk(1, [&](T& value, size_t) { fill(value); }) == 1;
+        }
+
+        // Consumer only. Calls handle(value) for up to max ready slots in order, returns how
+        // many it got through
+        template <typename Handle> size_t consume(size_t max, Handle&& handle) {
+            const auto head = this->head.load(std::memory_order_relaxed);
+
+            size_t count = 0;
+            while (count < max) {
+                auto& slot = this->slots[(head + count) & this->mask];
+                if (slot.ready.load(std::memory_order_acquire) != head + count + 1) {
+                    break;
+                }
+
+                handle(slot.value);
+                count++;
+            }
+
+            if (count != 0) {
+                this->head.store(head + count, std::memory_order_release);
+            }
+            return count;
+        }
+
+        // Either side, only a snapshot
+        size_t size() const noexcept {
+            return this->tail.load(std::memory_order_acquire) -
+                   this->head.load(std::memory_order_acquire);
+        }
+
+        size_t capacity() const noexcept { return this->mask + 1; }
+
+    private:
+        struct Slot {
+            std::atomic<size_t> ready{0}; // Position + 1 once the producer is done with it
+            T                   value{};
+        };
+
+    private:
+        std::unique_ptr<Slot[]> slots{};
+        size_t                  mask{};
+
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail{0};
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> head{0};
+    };
+} // namespace rakro
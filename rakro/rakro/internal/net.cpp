@@ -34,6 +34,21 @@ namespace rakro::detail {
         );
     }
 
+    bool UdpSocket::has_pending() noexcept {
+#ifdef _WIN32
+        u_long pending = 0;
+        if (ioctlsocket(this->sock_handle, FIONREAD, &pending) != 0) {
+            return false;
+        }
+#else
+        int pending = 0;
+        if (ioctl(this->sock_handle, FIONREAD, &pending) != 0) {
+            return false;
+        }
+#endif
+        return pending > 0;
+    }
+
     std::expected<std::pair<size_t, IPV4Addr>, SocketError>
     UdpSocket::recv_value(std::span<uint8_t> buffer) noexcept {
 
@@ -110,10 +125,22 @@ namespace rakro::detail {
             );
         }
 
-        int timeout = 2000; // 2 seconds
+        this->sock_handle = sock;
+        this->set_recv_timeout(2000); // 2 seconds
+    }
 
-        result = setsockopt(
-            sock, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout),
+    void UdpSocket::set_recv_timeout(uint32_t milliseconds) {
+#ifdef _WIN32
+        DWORD timeout = milliseconds;
+#else
+        timeval timeout{
+            .tv_sec  = static_cast<time_t>(milliseconds / 1000),
+            .tv_usec = static_cast<suseconds_t>((milliseconds % 1000) * 1000)
+        };
+#endif
+
+        const auto result = setsockopt(
+            this->sock_handle, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout),
             sizeof(timeout)
         );
 
@@ -122,7 +149,5 @@ namespace rakro::detail {
                 std::format("Failed to set socket: {} error", get_last_error())
             );
         }
-
-        this->sock_handle = sock;
     }
 } // namespace rakro::detail
\ No newline at end of file
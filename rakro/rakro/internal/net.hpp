@@ -17,6 +17,7 @@ using socklen_t = int;
 #include <errno.h>
 #include <fcntl.h>
 #include <netinet/in.h>
+#include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -48,6 +49,12 @@ namespace rakro::detail {
             return address.sin_addr.s_addr == other.address.sin_addr.s_addr &&
                    address.sin_port == other.address.sin_port;
         }
+
+        // IP in the high 32 bits and the port in the low 16, both kept in network order
+        uint64_t packed() const noexcept {
+            return (uint64_t{std::bit_cast<uint32_t>(this->address.sin_addr)} << 16) |
+                   std::bit_cast<uint16_t>(this->address.sin_port);
+        }
     };
 
     class UdpSocket {
@@ -59,6 +66,12 @@ namespace rakro::detail {
 
         int send(std::span<uint8_t> buffer, const IPV4Addr& address);
 
+        // True if at least one datagram can be read without blocking
+        bool has_pending() noexcept;
+
+        // How long recv_value blocks before giving up with a timeout error
+        void set_recv_timeout(uint32_t milliseconds);
+
     private:
         socket_t sock_handle{};
     };
@@ -70,6 +83,14 @@ namespace rakro::detail {
                                        .count());
     }
 
+    // Only good for measuring how long something took, it never goes backwards
+    inline uint64_t monotonic_micros() noexcept {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch()
+        )
+                                         .count());
+    }
+
 } // namespace rakro::detail
 
 namespace std {
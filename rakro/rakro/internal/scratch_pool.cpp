@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <bit>
+#include <rakro/internal/scratch_pool.hpp>
+
+namespace rakro {
+
+    // Anything smaller isnt worth pooling on its own
+    constexpr size_t MIN_SCRATCH_SIZE = 4096;
+
+    void RentedScratch::give_back() noexcept {
+        if (this->memory && this->owner) {
+            this->owner->give_back(std::move(this->memory), this->capacity);
+        }
+        this->capacity = 0;
+        this->owner    = nullptr;
+    }
+
+    RentedScratch ScratchPool::try_rent(size_t size) {
+        // Only reserved here, rent takes it from the free list or allocates as usual
+        const auto capacity = std::bit_ceil(std::max(size, MIN_SCRATCH_SIZE));
+        auto       current  = this->outstanding.load(std::memory_order_relaxed);
+
+        do {
+            if (current > this->max_outstanding || capacity > this->max_outstanding - current) {
+                return RentedScratch();
+            }
+        } while (!this->outstanding.compare_exchange_weak(
+            current, current + capacity, std::memory_order_relaxed
+        ));
+
+        auto scratch = this->rent(size);
+        this->outstanding.fetch_sub(capacity, std::memory_order_relaxed);
+        return scratch;
+    }
+
+    RentedScratch ScratchPool::rent(size_t size) {
+        {
+            const auto lock = std::unique_lock(this->free_mutex);
+
+            // Smallest block that fits, the list is short enough to just walk
+            auto best = this->free_blocks.end();
+            for (auto block = this->free_blocks.begin(); block != this->free_blocks.end();
+                 block++) {
+                if (block->capacity >= size &&
+                    (best == this->free_blocks.end() || block->capacity < best->capacity)) {
+                    best = block;
+                }
+            }
+
+            if (best != this->free_blocks.end()) {
+                auto block = std::move(*best);
+                *best      = std::move(this->free_blocks.back());
+                this->free_blocks.pop_back();
+
+                this->outstanding.fetch_add(block.capacity, std::memory_order_relaxed);
+                return RentedScratch(std::move(block.memory), block.capacity, this);
+            }
+        }
+
+        const auto capacity = std::bit_ceil(std::max(size, MIN_SCRATCH_SIZE));
+        auto       memory   = std::make_unique_for_overwrite<uint8_t[]>(capacity);
+
+        this->outstanding.fetch_add(capacity, std::memory_order_relaxed);
+        return RentedScratch(std::move(memory), capacity, this);
+    }
+
+    void ScratchPool::give_back(std::unique_ptr<uint8_t[]> memory, size_t capacity) noexcept {
+        this->outstanding.fetch_sub(capacity, std::memory_order_relaxed);
+
+        if (capacity > this->max_retained) {
+            return;
+        }
+
+        const auto lock = std::unique_lock(this->free_mutex);
+
+        // Reserved up front, so this never allocates
+        if (this->free_blocks.size() < this->max_free) {
+            this->free_blocks.push_back({.memory = std::move(memory), .capacity = capacity});
+        }
+    }
+} // namespace rakro
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace rakro {
+
+    class ScratchPool;
+
+    // A block of memory bigger than what BufferCompany hands out, for things like split
+    // packets being put back together. It isnt zeroed, and it goes back to the pool when
+    // dropped
+    class RentedScratch {
+    public:
+        RentedScratch() = default;
+        RentedScratch(std::unique_ptr<uint8_t[]> memory, size_t capacity, ScratchPool* owner)
+            : memory(std::move(memory)), capacity(capacity), owner(owner) {}
+        RentedScratch(RentedScratch&& other) noexcept
+            : memory(std::move(other.memory)), capacity(std::exchange(other.capacity, 0)),
+              owner(std::exchange(other.owner, nullptr)) {}
+        RentedScratch& operator=(RentedScratch&& other) noexcept {
+            if (this != &other) {
+                this->give_back();
+                this->memory   = std::move(other.memory);
+                this->capacity = std::exchange(other.capacity, 0);
+                this->owner    = std::exchange(other.owner, nullptr);
+            }
+            return *this;
+        }
+        ~RentedScratch() noexcept { this->give_back(); }
+
+        std::span<uint8_t> get_memory() noexcept {
+            return {this->memory.get(), this->capacity};
+        }
+
+        explicit operator bool() const noexcept { return this->memory != nullptr; }
+
+    private:
+        void give_back() noexcept;
+
+    private:
+        std::unique_ptr<uint8_t[]> memory{};
+        size_t                     capacity{0};
+        ScratchPool*               owner{nullptr};
+    };
+
+    // Shared by every connection. Blocks are rounded up to a power of two so they get reused
+    // by rents of a similar size, anything past max_retained is freed instead of pooled.
+    // max_outstanding caps what try_rent hands out across every connection at once
+    class ScratchPool {
+    public:
+        explicit ScratchPool(
+            size_t max_outstanding = std::numeric_limits<size_t>::max(),
+            size_t max_retained = size_t{1} << 20, size_t max_free = 64
+        )
+            : max_outstanding(max_outstanding), max_retained(max_retained), max_free(max_free) {
+            this->free_blocks.reserve(max_free);
+        }
+        ScratchPool(const ScratchPool&) = delete;
+
+        // Always succeeds, rent counts towards max_outstanding but isnt held to it
+        RentedScratch rent(size_t size);
+        // Empty if the block would take what is rented out past max_outstanding
+        RentedScratch try_rent(size_t size);
+
+        // Bytes rented out right now, by capacity, from any thread
+        size_t get_outstanding() const noexcept {
+            return this->outstanding.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct FreeBlock {
+            std::unique_ptr<uint8_t[]> memory{};
+            size_t                     capacity{};
+        };
+
+        void give_back(std::unique_ptr<uint8_t[]> memory, size_t capacity) noexcept;
+
+    private:
+        size_t                 max_outstanding{};
+        std::atomic_size_t     outstanding{0};
+        size_t                 max_retained{};
+        size_t                 max_free{};
+        std::mutex             free_mutex{};
+        std::vector<FreeBlock> free_blocks{};
+
+        friend class RentedScratch;
+    };
+} // namespace rakro
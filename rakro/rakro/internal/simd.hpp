@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// SSE2 is part of the x86-64 baseline, so every 64 bit build we care about gets it. Anything
+// else falls back to the scalar paths
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define RAKRO_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace rakro::detail {
+#ifdef RAKRO_SSE2
+    // memcpy so we dont upset -Wcast-align, compiles down to a single movdqu
+    inline __m128i load_128(const uint8_t* data) noexcept {
+        __m128i value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    inline uint32_t byte_mask(__m128i value) noexcept {
+        return static_cast<uint32_t>(_mm_movemask_epi8(value));
+    }
+#endif
+} // namespace rakro::detail
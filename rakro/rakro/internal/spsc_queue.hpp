@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace rakro {
+
+    // Keeps the producer and consumer indexes off each other's cache line
+    constexpr size_t CACHE_LINE_SIZE = 64;
+
+    // Bounded lock free queue for exactly one producer thread and one consumer thread. The
+    // capacity is rounded up to a power of two. Each side keeps a cached copy of the other's
+    // index and only reloads it once the queue looks full or empty, so the shared lines are
+    // only touched about once per lap
+    template <typename T> class SpscQueue {
+    public:
+        explicit SpscQueue(size_t capacity)
+            : slots(std::make_unique<T[]>(std::bit_ceil(std::max(capacity, size_t{2})))),
+              mask(std::bit_ceil(std::max(capacity, size_t{2})) - 1) {}
+        SpscQueue(const SpscQueue&) = delete;
+
+        // Producer only. Leaves value alone and returns false if the queue is full
+        bool try_push(T&& value) noexcept {
+            const auto tail = this->producer.tail.load(std::memory_order_relaxed);
+
+            auto& cached_head = this->producer.cached_head;
+
+            if (tail - cached_head > this->mask) {
+                cached_head = this->consumer.head.load(std::memory_order_acquire);
+                if (tail - cached_head > this->mask) {
+                    return false;
+                }
+            }
+
+            this->slots[tail & this->mask] = std::move(value);
+            this->producer.tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer only
+        std::optional<T> try_pop() noexcept {
+            const auto head = this->consumer.head.load(std::memory_order_relaxed);
+
+            auto& cached_tail = this->consumer.cached_tail;
+
+            if (head == cached_tail) {
+                cached_tail = this->producer.tail.load(std::memory_order_acquire);
+                if (head == cached_tail) {
+                    return std::nullopt;
+                }
+            }
+
+            // Moved out and reset, so whatever the slot owned is released right away
+            auto value = std::exchange(this->slots[head & this->mask], T());
+            this->consumer.head.store(head + 1, std::memory_order_release);
+            return value;
+        }
+
+        // Either side, only a snapshot
+        size_t size() const noexcept {
+            return this->producer.tail.load(std::memory_order_acquire) -
+                   this->consumer.head.load(std::memory_order_acquire);
+        }
+
+        size_t capacity() const noexcept { return this->mask + 1; }
+
+    private:
+        struct alignas(CACHE_LINE_SIZE) ProducerSide {
+            std::atomic<size_t> tail{0};
+            size_t              cached_head{0};
+        };
+
+        struct alignas(CACHE_LINE_SIZE) ConsumerSide {
+            std::atomic<size_t> head{0};
+            size_t              cached_tail{0};
+        };
+
+    private:
+        std::unique_ptr<T[]> slots{};
+        size_t               mask{};
+        ProducerSide         producer{};
+        ConsumerSide         consumer{};
+    };
+} // namespace rakro
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace rakro {
+
+    // Refers to an armed timer, stays valid to cancel after it fired or was cancelled, it
+    // just doesnt do anything then
+    struct TimerHandle {
+        uint32_t index{std::numeric_limits<uint32_t>::max()};
+        uint32_t generation{0};
+
+        bool is_set() const noexcept {
+            return this->index != std::numeric_limits<uint32_t>::max();
+        }
+    };
+
+    // Hierarchical timing wheel, 4 levels of 64 slots. Level 0 has one slot per tick, every
+    // level above covers 64 times the range of the one below, so with 10ms ticks the wheel
+    // reaches about 46 hours out, anything further waits in the last slot and gets put back
+    // in once it comes up. Arming and cancelling are O(1), a timer is moved down a level at
+    // most 3 times before it fires.
+    //
+    // Timers live in one slab and are linked into their slot by index. Fired timers wait in
+    // a due list until advance gets to them, so a lot of them firing at once is spread over
+    // as many calls as the budget needs
+    template <typename T> class TimerWheel {
+    public:
+        explicit TimerWheel(uint64_t now, uint64_t resolution = 10)
+            : resolution(resolution), current(now / resolution) {}
+
+        // A deadline that already passed fires on the next advance
+        TimerHandle arm(uint64_t deadline, T value) {
+            const auto index = this->allocate();
+            auto&      node  = this->nodes[index];
+
+            node.tick  = deadline / this->resolution;
+            node.value = std::move(value);
+            this->insert(index);
+
+            return {.index = index, .generation = node.generation};
+        }
+
+        // Returns false if the timer already fired or was cancelled. Clears handle either way
+        bool cancel(TimerHandle& handle) noexcept {
+            const auto target = std::exchange(handle, TimerHandle());
+
+            if (!this->is_live(target)) {
+                return false;
+            }
+
+            this->unlink(target.index);
+            this->release(target.index);
+            return true;
+        }
+
+        // Moves an armed timer, or arms a new one if handle is not live anymore
+        void rearm(TimerHandle& handle, uint64_t deadline, T value) {
+            if (!this->is_live(handle)) {
+                handle = this->arm(deadline, std::move(value));
+                return;
+            }
+
+            auto& node = this->nodes[handle.index];
+            this->unlink(handle.index);
+
+            node.tick  = deadline / this->resolution;
+            node.value = std::move(value);
+            this->insert(handle.index);
+        }
+
+        bool is_live(TimerHandle handle) const noexcept {
+            return handle.is_set() && handle.index < this->nodes.size() &&
+                   this->nodes[handle.index].generation == handle.generation &&
+                   this->nodes[handle.index].list != FREE_LIST;
+        }
+
+        // Moves the wheel up to now and calls fn(T&&) for at most budget fired timers,
+        // returns how many it called. The timer is gone by the time fn runs, fn is free to
+        // arm and cancel timers
+        template <typename Fn> size_t advance(uint64_t now, size_t budget, Fn&& fn) {
+            const auto target = now / this->resolution;
+
+            if (target > this->current && this->live == this->due) {
+                // Nothing left in the slots, no point walking them
+                this->current = target;
+            } else if (target > this->current && target - this->current >= WHEEL_SPAN) {
+                // Way past everything the wheel can hold, the clock probably jumped
+                for (uint32_t list = 0; list < SLOT_LISTS; list++) {
+                    this->splice_into_due(list);
+                }
+                this->current = target;
+            }
+
+            while (this->current < target) {
+                this->current++;
+                this->cascade();
+                this->splice_into_due(this->current & SLOT_MASK);
+            }
+
+            size_t fired = 0;
+            while (fired < budget && this->heads[DUE_LIST] != NIL) {
+                const auto index = this->heads[DUE_LIST];
+                auto       value = std::move(this->nodes[index].value);
+
+                this->unlink(index);
+                this->release(index);
+
+                fn(std::move(value));
+                fired++;
+            }
+            return fired;
+        }
+
+        size_t size() const noexcept { return this->live; }
+        size_t get_due() const noexcept { return this->due; }
+
+    private:
+        static constexpr uint32_t LEVELS     = 4;
+        static constexpr uint32_t SLOT_BITS  = 6;
+        static constexpr uint32_t SLOTS      = 1u << SLOT_BITS;
+        static constexpr uint64_t SLOT_MASK  = SLOTS - 1;
+        static constexpr uint64_t WHEEL_SPAN = uint64_t{1} << (SLOT_BITS * LEVELS);
+        static constexpr uint32_t SLOT_LISTS = LEVELS * SLOTS;
+        static constexpr uint32_t DUE_LIST   = SLOT_LISTS;
+        static constexpr uint32_t FREE_LIST  = SLOT_LISTS + 1;
+        static constexpr uint32_t NIL        = std::numeric_limits<uint32_t>::max();
+
+        struct Node {
+            uint64_t tick{};
+            T        value{};
+            uint32_t prev{NIL};
+            uint32_t next{NIL};
+            uint32_t list{FREE_LIST}; // Slot (level * SLOTS + slot), due or free
+            uint32_t generation{0};
+        };
+
+        uint32_t allocate() {
+            this->live++;
+
+            if (this->free_head != NIL) {
+                return std::exchange(this->free_head, this->nodes[this->free_head].next);
+            }
+
+            this->nodes.emplace_back();
+            return static_cast<uint32_t>(this->nodes.size() - 1);
+        }
+
+        void release(uint32_t index) noexcept {
+            auto& node = this->nodes[index];
+
+            node.value = T();
+            node.list  = FREE_LIST;
+            node.prev  = NIL;
+            node.next  = std::exchange(this->free_head, index);
+            node.generation++;
+            this->live--;
+        }
+
+        // Picks the lowest level whose range covers the deadline, relative to current
+        void insert(uint32_t index) {
+            const auto tick = this->nodes[index].tick;
+
+            if (tick <= this->current) {
+                this->link(index, DUE_LIST);
+                return;
+            }
+
+            const auto delta = tick - this->current;
+
+            for (uint32_t level = 0; level < LEVELS; level++) {
+                if (delta < (uint64_t{1} << (SLOT_BITS * (level + 1)))) {
+                    const auto slot = (tick >> (SLOT_BITS * level)) & SLOT_MASK;
+                    this->link(index, level * SLOTS + static_cast<uint32_t>(slot));
+                    return;
+                }
+            }
+
+            // Out of range, parks in the top level slot that comes up last
+            const auto top  = LEVELS - 1;
+            const auto slot = ((this->current >> (SLOT_BITS * top)) - 1) & SLOT_MASK;
+            this->link(index, top * SLOTS + static_cast<uint32_t>(slot));
+        }
+
+        // Once a lower level wraps, the slot of the level above that just came up is spread
+        // over the levels below it. Highest first, so things can fall more than one level
+        void cascade() {
+            for (uint32_t level = LEVELS - 1; level > 0; level--) {
+                const auto bits = SLOT_BITS * level;
+
+                if ((this->current & ((uint64_t{1} << bits) - 1)) != 0) {
+                    continue;
+                }
+
+                const auto slot = (this->current >> bits) & SLOT_MASK;
+                const auto list = level * SLOTS + static_cast<uint32_t>(slot);
+
+                auto index = std::exchange(this->heads[list], NIL);
+                while (index != NIL) {
+                    const auto next         = this->nodes[index].next;
+                    this->nodes[index].prev = NIL;
+                    this->insert(index);
+                    index = next;
+                }
+            }
+        }
+
+        void splice_into_due(uint64_t list) {
+            auto index = std::exchange(this->heads[list], NIL);
+
+            while (index != NIL) {
+                const auto next = this->nodes[index].next;
+                this->nodes[index].prev = NIL;
+                this->link(index, DUE_LIST);
+                index = next;
+            }
+        }
+
+        void link(uint32_t index, uint32_t list) noexcept {
+            auto& node = this->nodes[index];
+
+            node.list = list;
+            node.prev = NIL;
+            node.next = this->heads[list];
+
+            if (node.next != NIL) {
+                this->nodes[node.next].prev = index;
+            }
+            this->heads[list] = index;
+
+            this->due += list == DUE_LIST;
+        }
+
+        void unlink(uint32_t index) noexcept {
+            auto& node = this->nodes[index];
+
+            if (node.prev != NIL) {
+                this->nodes[node.prev].next = node.next;
+            } else {
+                this->heads[node.list] = node.next;
+            }
+
+            if (node.next != NIL) {
+                this->nodes[node.next].prev = node.prev;
+            }
+
+            this->due -= node.list == DUE_LIST;
+            node.prev = NIL;
+            node.next = NIL;
+        }
+
+        static constexpr std::array<uint32_t, SLOT_LISTS + 1> empty_heads() noexcept {
+            auto heads = std::array<uint32_t, SLOT_LISTS + 1>();
+            heads.fill(NIL);
+            return heads;
+        }
+
+    private:
+        std::vector<Node>                    nodes{};
+        std::array<uint32_t, SLOT_LISTS + 1> heads{empty_heads()}; // Every slot, then due
+        uint32_t                             free_head{NIL};
+        uint64_t                             resolution{10};
+        uint64_t                             current{0};
+        size_t                               live{0};
+        size_t                               due{0};
+    };
+} // namespace rakro
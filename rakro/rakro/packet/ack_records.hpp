@@ -0,0 +1,207 @@
+#pragma once
+
+#include "rakro/internal/binary_buffer.hpp"
+#include "rakro/internal/int24_t.hpp"
+#include "rakro/packet/packet_id.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <utility>
+
+// ACK and NACK datagrams share the same body:
+//
+// id (1) | record count (2, BE) | records
+//
+// where each record is either a single sequence number or an inclusive range:
+//
+// single: 0x01 | sequence (3, LE)
+// range:  0x00 | start (3, LE) | end (3, LE)
+namespace rakro::packets {
+
+    constexpr size_t SINGLE_RECORD_SIZE = 4;
+    constexpr size_t RANGE_RECORD_SIZE  = 7;
+    constexpr size_t ACK_HEADER_SIZE    = 3;
+
+    // Inclusive range of datagram sequence numbers, may wrap past 0xFFFFFF
+    struct SequenceRange {
+        uint24_t start{};
+        uint24_t end{};
+
+        uint32_t size() const noexcept { return ((end - start).get_value() & 0xFFFFFF) + 1; }
+
+        bool contains(uint24_t value) const noexcept {
+            return ((value - start).get_value() & 0xFFFFFF) < this->size();
+        }
+    };
+
+    namespace detail {
+        inline size_t record_size(uint8_t single) noexcept {
+            return single ? SINGLE_RECORD_SIZE : RANGE_RECORD_SIZE;
+        }
+    } // namespace detail
+
+    // Non owning view over the raw records of an ACK or NACK, iterating it yields one
+    // SequenceRange per record straight out of the datagram bytes, nothing is copied or
+    // allocated. The bytes have to outlive the view
+    class AckRecordView {
+    public:
+        class Iterator {
+        public:
+            using value_type      = SequenceRange;
+            using difference_type = std::ptrdiff_t;
+
+            Iterator() = default;
+            Iterator(const uint8_t* cursor, uint16_t remaining)
+                : cursor(cursor), remaining(remaining) {}
+
+            SequenceRange operator*() const noexcept {
+                const auto start = uint24_t::from_le_bytes(this->cursor + 1);
+                return SequenceRange{
+                    .start = start,
+                    .end   = this->cursor[0] ? start : uint24_t::from_le_bytes(this->cursor + 4)
+                };
+            }
+
+            Iterator& operator++() noexcept {
+                this->cursor += detail::record_size(this->cursor[0]);
+                this->remaining--;
+                return *this;
+            }
+
+            Iterator operator++(int) noexcept {
+                auto previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            bool operator==(const Iterator& other) const noexcept {
+                return this->remaining == other.remaining;
+            }
+
+        private:
+            const uint8_t* cursor{nullptr};
+            uint16_t       remaining{0};
+        };
+
+        AckRecordView() = default;
+
+        // Walks the records once to make sure all of them are in bounds, after that iterating
+        // does no checks at all
+        static std::optional<AckRecordView>
+        from_bytes(std::span<const uint8_t> records, uint16_t count) noexcept {
+            size_t length = 0;
+
+            for (uint16_t x = 0; x < count; x++) {
+                if (length >= records.size()) {
+                    return std::nullopt;
+                }
+
+                length += detail::record_size(records[length]);
+
+                if (length > records.size()) {
+                    return std::nullopt;
+                }
+            }
+
+            return AckRecordView(records.subspan(0, length), count);
+        }
+
+        Iterator begin() const noexcept { return Iterator(this->records.data(), this->count); }
+        Iterator end() const noexcept { return Iterator(nullptr, 0); }
+
+        size_t                   size() const noexcept { return this->count; }
+        std::span<const uint8_t> bytes() const noexcept { return this->records; }
+
+    private:
+        AckRecordView(std::span<const uint8_t> records, uint16_t count)
+            : records(records), count(count) {}
+
+        std::span<const uint8_t> records{};
+        uint16_t                 count{0};
+    };
+
+    static_assert(std::input_iterator<AckRecordView::Iterator>);
+
+    namespace detail {
+        // Writes the id and a placeholder count, the count gets patched in by
+        // finish_ack_records once we know how many records fit
+        inline size_t begin_ack_records(PacketId id, BinaryBuffer& buffer) {
+            buffer.write(std::to_underlying(id));
+            const auto count_index = buffer.consumed();
+            buffer.write(uint16_t{0});
+            return count_index;
+        }
+
+        inline void
+        finish_ack_records(size_t count_index, uint16_t count, BinaryBuffer& buffer) {
+            const auto end_index = buffer.consumed();
+            buffer.go_to(count_index);
+            buffer.write(count);
+            buffer.go_to(end_index);
+        }
+
+        // Returns false without writing anything if the record doesnt fit
+        inline bool write_range_record(SequenceRange range, BinaryBuffer& buffer) {
+            const bool single = range.start == range.end;
+
+            if (buffer.remaining() < record_size(single)) {
+                return false;
+            }
+
+            buffer.write(single);
+            buffer.write(range.start);
+            if (!single) {
+                buffer.write(range.end);
+            }
+            return true;
+        }
+    } // namespace detail
+
+    // Encodes already collapsed ranges, returns how many of them fit in the buffer
+    inline size_t write_ack_records(
+        PacketId id, std::span<const SequenceRange> ranges, BinaryBuffer& buffer
+    ) {
+        const auto count_index = detail::begin_ack_records(id, buffer);
+
+        size_t written = 0;
+        while (written < ranges.size() && written < UINT16_MAX &&
+               detail::write_range_record(ranges[written], buffer)) {
+            written++;
+        }
+
+        detail::finish_ack_records(count_index, static_cast<uint16_t>(written), buffer);
+        return written;
+    }
+
+    // Encodes a sorted run of sequence numbers, consecutive numbers are collapsed into one
+    // range record on the fly. Returns how many sequence numbers made it into the buffer, so
+    // the caller can carry the rest over into the next datagram
+    inline size_t
+    write_ack_records(PacketId id, std::span<const uint24_t> sorted, BinaryBuffer& buffer) {
+        const auto count_index = detail::begin_ack_records(id, buffer);
+
+        size_t   consumed = 0;
+        uint16_t records  = 0;
+
+        while (consumed < sorted.size() && records < UINT16_MAX) {
+            auto range = SequenceRange{.start = sorted[consumed], .end = sorted[consumed]};
+            auto next  = consumed + 1;
+
+            while (next < sorted.size() && sorted[next] == range.end + 1) {
+                range.end = sorted[next++];
+            }
+
+            if (!detail::write_range_record(range, buffer)) {
+                break;
+            }
+
+            records++;
+            consumed = next;
+        }
+
+        detail::finish_ack_records(count_index, records, buffer);
+        return consumed;
+    }
+} // namespace rakro::packets
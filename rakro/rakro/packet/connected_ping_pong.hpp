@@ -18,8 +18,9 @@ namespace rakro::packets {
 namespace rakro {
     template <> struct BinaryDataInterface<packets::ConnectedPing> {
 
-        static void write(const packets::ConnectedPing& /*unused*/, BinaryBuffer& buff) {
-            throw std::logic_error("unimplemented");
+        // Only the body, the id is written by whoever sends it
+        static void write(const packets::ConnectedPing& self, BinaryBuffer& buff) {
+            buff.write(self.time_since_start);
         }
 
         static packets::ConnectedPing read(BinaryBuffer& buffer) {
@@ -41,7 +42,11 @@ namespace rakro {
         }
 
         static packets::ConnectedPong read(BinaryBuffer& buffer) {
-            throw std::logic_error("Unimplemented");
+            const auto time_since_start = buffer.read_next<uint64_t>();
+            return {
+                .time_since_start        = time_since_start,
+                .time_since_server_start = buffer.read_next<uint64_t>(),
+            };
         }
 
         static size_t size(const std::optional<packets::ConnectedPong>& /*unused*/) {
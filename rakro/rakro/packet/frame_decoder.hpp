@@ -0,0 +1,117 @@
+#pragma once
+
+#include "rakro/internal/binary_buffer.hpp"
+#include "rakro/internal/int24_t.hpp"
+#include "rakro/packet/frame_set.hpp"
+#include <array>
+#include <cstdint>
+
+namespace rakro::packets {
+
+    namespace detail {
+        // Where every field of a frame header sits, relative to the flags byte. An offset of
+        // 0 means the field isnt there (the flags byte always owns offset 0), and a
+        // header_size of 0 means the flags need the generic reader
+        struct FrameLayout {
+            uint8_t header_size{0};
+            uint8_t reliable_offset{0};
+            uint8_t sequence_offset{0};
+            uint8_t order_offset{0};
+        };
+
+        constexpr FrameLayout make_frame_layout(uint8_t flags) noexcept {
+            const auto rely = static_cast<FrameReliability>(flags >> 5);
+
+            // Fragments and the receipt reliabilities are rare enough to not be worth a table
+            // entry, they go through BinaryDataInterface<FrameInfo>
+            if ((flags & IS_FRAGMENTED) || rely > FrameReliability::ReliableSequenced) {
+                return {};
+            }
+
+            // flags (1) + bit length (2)
+            size_t      offset = 3;
+            FrameLayout layout{};
+
+            if (is_reliable(rely)) {
+                layout.reliable_offset = static_cast<uint8_t>(offset);
+                offset += 3;
+            }
+
+            if (is_seq(rely)) {
+                layout.sequence_offset = static_cast<uint8_t>(offset);
+                offset += 3;
+            }
+
+            if (is_ordered(rely)) {
+                layout.order_offset = static_cast<uint8_t>(offset);
+                offset += 4; // index (3) + channel (1)
+            }
+
+            layout.header_size = static_cast<uint8_t>(offset);
+            return layout;
+        }
+
+        // Indexed by the raw flags byte, so the low bits we dont care about cost nothing
+        constexpr auto frame_layouts = [] {
+            std::array<FrameLayout, 256> layouts{};
+            for (size_t flags = 0; flags < layouts.size(); flags++) {
+                layouts[flags] = make_frame_layout(static_cast<uint8_t>(flags));
+            }
+            return layouts;
+        }();
+    } // namespace detail
+
+    namespace detail {
+        // Fills info straight out of the layout table, false if the generic reader is needed
+        inline bool read_frame_info_fast(BinaryBuffer& buffer, FrameInfo& info) noexcept {
+            const auto remaining = buffer.remaining_slice();
+
+            if (remaining.empty()) [[unlikely]] {
+                return false;
+            }
+
+            const auto layout = frame_layouts[remaining[0]];
+
+            if (layout.header_size == 0 || remaining.size() < layout.header_size) [[unlikely]] {
+                return false;
+            }
+
+            const uint8_t* data = remaining.data();
+
+            info.rely      = static_cast<FrameReliability>(data[0] >> 5);
+            info.body_leng = static_cast<uint16_t>(((data[1] << 8) | data[2]) >> 3);
+
+            if (layout.reliable_offset != 0) {
+                info.reliability_index = uint24_t::from_le_bytes(data + layout.reliable_offset);
+            }
+
+            if (layout.sequence_offset != 0) {
+                info.sequence_frame_index =
+                    uint24_t::from_le_bytes(data + layout.sequence_offset);
+            }
+
+            if (layout.order_offset != 0) {
+                info.order_info = FrameInfo::OrderInformation{
+                    .order_frame_index = uint24_t::from_le_bytes(data + layout.order_offset),
+                    .order_channel     = data[layout.order_offset + 3]
+                };
+            }
+
+            buffer.skipn(layout.header_size);
+            return true;
+        }
+    } // namespace detail
+
+    // Drop in for buffer.read_next<FrameInfo>(). Unfragmented frames of the plain
+    // reliabilities are decoded with one bounds check and fixed offset loads out of the
+    // layout table, anything else falls back to the generic reader
+    inline FrameInfo read_frame_info(BinaryBuffer& buffer) {
+        FrameInfo info{};
+
+        if (!detail::read_frame_info_fast(buffer, info)) [[unlikely]] {
+            info = buffer.read_next<FrameInfo>();
+        }
+
+        return info;
+    }
+} // namespace rakro::packets
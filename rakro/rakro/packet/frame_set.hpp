@@ -8,7 +8,8 @@
 namespace rakro::packets {
     constexpr size_t VALID_FRAME_MASK   = 0x80;
     constexpr size_t VALID_MAX_FRAME_ID = 0x8D;
-    constexpr size_t IS_ORDERD          = 0x10;
+    constexpr size_t IS_FRAGMENTED      = 0x10;
+    constexpr size_t FRAME_HEADER_SIZE  = 4; // id (1) + sequence number (3)
 
     struct FrameHeader {
         uint24_t sequence_number{};
@@ -61,18 +62,40 @@ namespace rakro::packets {
     };
 
     namespace detail {
-        inline bool is_reliable(FrameReliability rely) {
+        constexpr bool is_reliable(FrameReliability rely) {
             return (rely == FrameReliability::Reliable) ||
                    (rely == FrameReliability::ReliableOrdered) ||
-                   (rely == FrameReliability::ReliableSequenced);
+                   (rely == FrameReliability::ReliableSequenced) ||
+                   (rely == FrameReliability::ReliableWithAckReceipt) ||
+                   (rely == FrameReliability::ReliableOrderedWithAckReceipt);
+        }
+
+        constexpr bool has_ack_receipt(FrameReliability rely) {
+            return (rely == FrameReliability::UnreliableWithAckReceipt) ||
+                   (rely == FrameReliability::ReliableWithAckReceipt) ||
+                   (rely == FrameReliability::ReliableOrderedWithAckReceipt);
+        }
+
+        // Receipts are tracked by the sender alone, RakNet never puts these on the wire
+        constexpr FrameReliability without_ack_receipt(FrameReliability rely) {
+            switch (rely) {
+            case FrameReliability::UnreliableWithAckReceipt:
+                return FrameReliability::Unreliable;
+            case FrameReliability::ReliableWithAckReceipt:
+                return FrameReliability::Reliable;
+            case FrameReliability::ReliableOrderedWithAckReceipt:
+                return FrameReliability::ReliableOrdered;
+            default:
+                return rely;
+            }
         }
 
-        inline bool is_seq(FrameReliability rely) {
+        constexpr bool is_seq(FrameReliability rely) {
             return (rely == FrameReliability::UnreliableSequenced) ||
                    (rely == FrameReliability::ReliableSequenced);
         }
 
-        inline bool is_ordered(FrameReliability rely) {
+        constexpr bool is_ordered(FrameReliability rely) {
             return (rely == FrameReliability::UnreliableSequenced) ||
                    (rely == FrameReliability::ReliableOrdered) ||
                    (rely == FrameReliability::ReliableSequenced) ||
@@ -118,8 +141,8 @@ namespace rakro {
             return {.sequence_number = buffer.read_next<uint24_t>()};
         }
 
-        static size_t size(const std::optional<packets::FrameHeader>& val) {
-            return 4 - static_cast<size_t>(val.has_value());
+        static size_t size(const std::optional<packets::FrameHeader>& /*unused*/) {
+            return packets::FRAME_HEADER_SIZE;
         }
     };
 
@@ -129,9 +152,10 @@ namespace rakro {
 namespace rakro {
     template <> struct BinaryDataInterface<packets::FrameInfo> {
         static void write(packets::FrameInfo self, BinaryBuffer& buffer) {
-            buffer.write<uint8_t>(
-                std::to_underlying(self.rely) | ((self.fragment_info.has_value()) ? 0x4 : 0)
-            );
+            buffer.write<uint8_t>(static_cast<uint8_t>(
+                (std::to_underlying(self.rely) << 5) |
+                ((self.fragment_info.has_value()) ? packets::IS_FRAGMENTED : 0)
+            ));
             buffer.write<uint16_t>(static_cast<uint16_t>(self.body_leng << 3));
 
             if (self.reliability_index.has_value()) {
@@ -160,6 +184,7 @@ namespace rakro {
             const auto         rely = static_cast<packets::FrameReliability>(flags >> 5);
             packets::FrameInfo info{};
 
+            info.rely      = rely;
             info.body_leng = static_cast<uint16_t>(buffer.read_next<uint16_t>() >> 3);
 
             if (packets::detail::is_reliable(rely)) {
@@ -177,7 +202,7 @@ namespace rakro {
                 };
             }
 
-            if (flags & packets::IS_ORDERD) {
+            if (flags & packets::IS_FRAGMENTED) {
                 info.fragment_info = packets::FrameInfo::FragmentInformation{
                     .fragment_size        = buffer.read_next<uint32_t>(),
                     .fragment_compound_id = buffer.read_next<uint16_t>(),
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <span>
+
+// Game batches (0xFE) are what bedrock sends all of its own packets in:
+//
+// 0xFE | algorithm (1, only once compression has been negotiated) | payload
+//
+// and the payload, after decompressing, is a run of length prefixed packets:
+//
+// length (varuint32) | packet | length (varuint32) | packet ...
+namespace rakro::packets {
+
+    enum class BatchCompression : uint8_t { Deflate = 0x00, Snappy = 0x01, None = 0xFF };
+
+    constexpr size_t MAX_VARUINT32_SIZE = 5;
+
+    namespace detail {
+        // Returns how many bytes the varint took, 0 if it is truncated or longer than 5 bytes
+        inline size_t read_varuint32(std::span<const uint8_t> bytes, uint32_t& value) noexcept {
+            value = 0;
+
+            for (size_t x = 0; x < MAX_VARUINT32_SIZE && x < bytes.size(); x++) {
+                value |= static_cast<uint32_t>(bytes[x] & 0x7F) << (x * 7);
+
+                if ((bytes[x] & 0x80) == 0) {
+                    return x + 1;
+                }
+            }
+
+            return 0;
+        }
+
+        // out needs room for MAX_VARUINT32_SIZE bytes, returns how many were written
+        inline size_t write_varuint32(uint32_t value, uint8_t* out) noexcept {
+            size_t written = 0;
+
+            while (value >= 0x80) {
+                out[written++] = static_cast<uint8_t>(value | 0x80);
+                value >>= 7;
+            }
+
+            out[written++] = static_cast<uint8_t>(value);
+            return written;
+        }
+
+        constexpr size_t varuint32_size(uint32_t value) noexcept {
+            size_t size = 1;
+            while (value >= 0x80) {
+                value >>= 7;
+                size++;
+            }
+            return size;
+        }
+    } // namespace detail
+
+    // Non owning view over a decompressed batch payload, iterating it yields a span per
+    // packet pointing straight into the payload. Same deal as AckRecordView, the bytes are
+    // checked once up front and have to outlive the view
+    class BatchView {
+    public:
+        class Iterator {
+        public:
+            using value_type      = std::span<uint8_t>;
+            using difference_type = std::ptrdiff_t;
+
+            Iterator() = default;
+            Iterator(uint8_t* cursor, uint8_t* end) : cursor(cursor), end(end) {}
+
+            std::span<uint8_t> operator*() const noexcept {
+                uint32_t   length = 0;
+                const auto prefix = detail::read_varuint32(this->remaining(), length);
+                return std::span(this->cursor + prefix, length);
+            }
+
+            Iterator& operator++() noexcept {
+                uint32_t   length = 0;
+                const auto prefix = detail::read_varuint32(this->remaining(), length);
+                this->cursor += prefix + length;
+                return *this;
+            }
+
+            Iterator operator++(int) noexcept {
+                auto previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            bool operator==(const Iterator& other) const noexcept {
+                return this->cursor == other.cursor;
+            }
+
+        private:
+            std::span<const uint8_t> remaining() const noexcept {
+                return std::span<const uint8_t>(this->cursor, this->end);
+            }
+
+            uint8_t* cursor{nullptr};
+            uint8_t* end{nullptr};
+        };
+
+        BatchView() = default;
+
+        static std::optional<BatchView> from_bytes(std::span<uint8_t> payload) noexcept {
+            size_t offset = 0;
+            size_t count  = 0;
+
+            while (offset < payload.size()) {
+                uint32_t   length = 0;
+                const auto prefix = detail::read_varuint32(payload.subspan(offset), length);
+
+                if (prefix == 0 || length > payload.size() - offset - prefix) {
+                    return std::nullopt;
+                }
+
+                offset += prefix + length;
+                count++;
+            }
+
+            return BatchView(payload, count);
+        }
+
+        Iterator begin() const noexcept {
+            return Iterator(this->payload.data(), this->payload.data() + this->payload.size());
+        }
+        Iterator end() const noexcept {
+            const auto end = this->payload.data() + this->payload.size();
+            return Iterator(end, end);
+        }
+
+        size_t             size() const noexcept { return this->count; }
+        std::span<uint8_t> bytes() const noexcept { return this->payload; }
+
+    private:
+        BatchView(std::span<uint8_t> payload, size_t count) : payload(payload), count(count) {}
+
+        std::span<uint8_t> payload{};
+        size_t             count{0};
+    };
+
+    static_assert(std::input_iterator<BatchView::Iterator>);
+} // namespace rakro::packets
@@ -1,6 +1,8 @@
 #pragma once
 #include <array>
 #include <rakro/internal/binary_buffer.hpp>
+#include <rakro/internal/simd.hpp>
+#include <stdexcept>
 
 namespace rakro {
 
@@ -8,6 +10,18 @@ namespace rakro {
                                                0xfd, 0xfd, 0xfd, 0xfd, 0x12, 0x34, 0x56, 0x78};
     using MagicType                         = decltype(Magic);
 
+    namespace detail {
+        // Expects at least 16 readable bytes at data
+        inline bool is_offline_magic(const uint8_t* data) noexcept {
+#ifdef RAKRO_SSE2
+            const auto equal = _mm_cmpeq_epi8(load_128(data), load_128(Magic.data()));
+            return byte_mask(equal) == 0xFFFF;
+#else
+            return std::memcmp(data, Magic.data(), Magic.size()) == 0;
+#endif
+        }
+    } // namespace detail
+
     template <> struct BinaryDataInterface<MagicType> {
 
         static void write(const MagicType& /*unused*/, BinaryBuffer& buff) {
@@ -17,9 +31,11 @@ namespace rakro {
         }
 
         static MagicType read(BinaryBuffer& buffer) {
-            for (size_t x = 0; x < Magic.size(); x++) {
-                (void)buffer.next_byte();
+            if (!detail::is_offline_magic(buffer.remaining_slice().data())) {
+                throw std::runtime_error("invalid offline magic");
             }
+
+            buffer.skipn(Magic.size());
             return Magic;
         }
 
@@ -30,4 +46,4 @@ namespace rakro {
 
     static_assert(BinaryData<MagicType>);
 
-}; // namespace rakro
\ No newline at end of file
+}; // namespace rakro
@@ -1,39 +1,29 @@
-
 #pragma once
 
 #include "rakro/internal/binary_buffer.hpp"
-#include "rakro/internal/int24_t.hpp"
+#include "rakro/packet/ack_records.hpp"
 #include "rakro/packet/packet_id.hpp"
-#include <generator>
 #include <optional>
+#include <span>
+#include <stdexcept>
 #include <utility>
-#include <variant>
 
 namespace rakro::packets {
     struct Nack {
-        struct MultiNack {
-            uint24_t start;
-            uint24_t end;
-        };
-
-        using Record = std::variant<uint24_t, MultiNack>;
-
-        std::vector<Record> records{};
+        AckRecordView records{};
 
         size_t count() const noexcept { return records.size(); }
 
-        std::generator<uint24_t> all_packets() const noexcept {
-            for (const auto& record : this->records) {
-                if (std::holds_alternative<MultiNack>(record)) {
-                    const auto range = std::get<MultiNack>(record);
-                    for (uint24_t x = range.start; x <= range.end; x++) {
-                        co_yield x;
-                    }
-                } else {
-                    const auto value = std::get<uint24_t>(record);
-                    co_yield value;
-                }
+        // Points straight into datagram, which has to start at the packet id
+        static std::optional<Nack> from_bytes(std::span<const uint8_t> datagram) noexcept {
+            if (datagram.size() < ACK_HEADER_SIZE) {
+                return std::nullopt;
             }
+
+            const auto count = static_cast<uint16_t>((datagram[1] << 8) | datagram[2]);
+
+            return AckRecordView::from_bytes(datagram.subspan(ACK_HEADER_SIZE), count)
+                .transform([](AckRecordView view) { return Nack{.records = view}; });
         }
     };
 } // namespace rakro::packets
@@ -45,38 +35,28 @@ namespace rakro {
             buffer.write(std::to_underlying(PacketId::Nack));
             buffer.write(static_cast<uint16_t>(self.count()));
 
-            for (size_t x = 0; x < self.count(); x++) {
-                if (std::holds_alternative<packets::Nack::MultiNack>(self.records[x])) {
-                    buffer.write(true);
-                    const auto range = std::get<packets::Nack::MultiNack>(self.records[x]);
-                    buffer.write(range.start);
-                    buffer.write(range.end);
-                } else {
-                    buffer.write(std::get<uint24_t>(self.records[x]));
-                }
+            for (const auto byte : self.records.bytes()) {
+                buffer.write_byte(byte);
             }
         }
 
         static packets::Nack read(BinaryBuffer& buffer) {
-            const auto length  = buffer.read_next<uint16_t>();
-            auto       records = std::vector<packets::Nack::Record>();
-            records.reserve(length);
+            const auto nack = packets::Nack::from_bytes(buffer.remaining_slice());
 
-            for (int x = 0; x < length; x++) {
-                if (buffer.read_next<bool>()) {
-                    records.push_back(packets::Nack::MultiNack{
-                        .start = buffer.read_next<uint24_t>(),
-                        .end   = buffer.read_next<uint24_t>()
-                    });
-                } else {
-                    records.push_back(buffer.read_next<uint24_t>());
-                }
+            if (!nack.has_value()) {
+                throw std::runtime_error("invalid nack records");
             }
 
-            return packets::Nack{.records = records};
+            buffer.skipn(packets::ACK_HEADER_SIZE + nack->records.bytes().size());
+            return nack.value();
         }
 
-        static size_t size(const std::optional<packets::Nack>& /*unused*/) { return 3; }
+        static size_t size(const std::optional<packets::Nack>& nack) {
+            return packets::ACK_HEADER_SIZE +
+                   nack.transform([](const packets::Nack& value) {
+                          return value.records.bytes().size();
+                      }).value_or(0);
+        }
     };
     static_assert(BinaryData<packets::Nack>);
-} // namespace rakro
\ No newline at end of file
+} // namespace rakro
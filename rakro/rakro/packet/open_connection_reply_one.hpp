@@ -3,6 +3,7 @@
 #include "packet_id.hpp"
 #include "rakro/packet/magic.hpp"
 #include <cstdint>
+#include <optional>
 #include <rakro/packet/open_connection_request_one.hpp>
 #include <stdexcept>
 #include <utility>
@@ -11,8 +12,10 @@ namespace rakro::packets {
     struct OpenConnectionReply1 {
         uint64_t server_guid{0xDEADC0DE};
         uint16_t MTU{};
+        // Sent with use security set, the client has to echo it in OCR2
+        std::optional<uint32_t> cookie{};
 
-        // Have to add + 1 for use security false and Magic is + 16
+        // Have to add + 1 for use security and Magic is + 16
     };
 
 } // namespace rakro::packets
@@ -23,7 +26,10 @@ namespace rakro {
             buffer.write(std::to_underlying(PacketId::OpenConnectionReply1));
             buffer.write(Magic);
             buffer.write(self.server_guid);
-            buffer.write(false);
+            buffer.write(self.cookie.has_value());
+            if (self.cookie.has_value()) {
+                buffer.write(self.cookie.value());
+            }
             buffer.write(self.MTU);
         }
 
@@ -32,7 +38,8 @@ namespace rakro {
         }
 
         static size_t size(const std::optional<packets::OpenConnectionReply1>& /*unused*/) {
-            return sizeof(packets::OpenConnectionReply1) + 2 + sizeof(MagicType);
+            return sizeof(uint64_t) + sizeof(uint16_t) + sizeof(uint32_t) + 2 +
+                   sizeof(MagicType);
         }
     };
 
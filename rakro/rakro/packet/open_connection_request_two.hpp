@@ -3,14 +3,21 @@
 #include "rak_address.hpp"
 #include "rakro/packet/magic.hpp"
 #include <cstdint>
+#include <optional>
 #include <stdexcept>
 
 namespace rakro::packets {
     struct OpenConnectionRequest2 {
         uint16_t mtu{};
         uint64_t client_guid{};
+        // Only there if our OCR1 reply had one, see OpenConnectionReply1
+        std::optional<uint32_t> cookie{};
     };
 
+    // Address, MTU and GUID after the magic, the cookie and the challenge flag add 5 more
+    constexpr size_t OCR2_BODY_SIZE        = 7 + 2 + 8;
+    constexpr size_t OCR2_COOKIE_BODY_SIZE = OCR2_BODY_SIZE + 4 + 1;
+
 } // namespace rakro::packets
 
 namespace rakro {
@@ -21,10 +28,19 @@ namespace rakro {
 
         static packets::OpenConnectionRequest2 read(BinaryBuffer& buffer) {
             (void)buffer.read_next<MagicType>();
+
+            // The client only knows whether we asked for a cookie, the length tells us too
+            auto cookie = std::optional<uint32_t>();
+            if (buffer.remaining() == packets::OCR2_COOKIE_BODY_SIZE) {
+                cookie = buffer.read_next<uint32_t>();
+                (void)buffer.read_next<bool>(); // Client wrote challenge, never with no key
+            }
+
             (void)buffer.read_next<packets::RakAddress>();
             return packets::OpenConnectionRequest2{
                 .mtu         = buffer.read_next<uint16_t>(), // MTU
-                .client_guid = buffer.read_next<uint64_t>()
+                .client_guid = buffer.read_next<uint64_t>(),
+                .cookie      = cookie
             };
         }
 
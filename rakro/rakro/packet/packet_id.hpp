@@ -6,6 +6,7 @@ namespace rakro {
         ConnectedPingPong         = 0x0,
         UnconnectedPing1          = 0x1,
         UnconnectedPing2          = 0x2,
+        ConnectedPong             = 0x3,
         UnconnectedPong           = 0x1C,
         OpenConnectionRequest1    = 0x5,
         OpenConnectionReply1      = 0x6,
@@ -14,8 +15,10 @@ namespace rakro {
         ConnectionRequest         = 0x9,
         ConnectionRequestAccepted = 0x10,
         NewIncommingConnection    = 0x13,
+        DisconnectionNotification = 0x15,
         IncompatibleProtocol      = 0x19,
         Ack                       = 0xC0,
-        Nack                      = 0xA0
+        Nack                      = 0xA0,
+        GameBatch                 = 0xFE
     };
 }
\ No newline at end of file
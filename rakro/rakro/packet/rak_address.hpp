@@ -57,7 +57,9 @@ namespace rakro {
                 throw std::runtime_error("invalid IP");
             }
 
-            return packets::RakAddress::from_bytes(buffer.remaining_slice()).value();
+            const auto address = packets::RakAddress::from_bytes(buffer.remaining_slice());
+            buffer.skipn(packets::RakAddress::size());
+            return address.value();
         }
 
         static size_t size(const std::optional<packets::RakAddress>& /*unused*/) {
@@ -0,0 +1,25 @@
+#include "admission.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace rakro {
+
+    AdmissionLane::AdmissionLane(AdmissionSettings settings)
+        : ring(std::max(settings.queue_capacity, size_t{1})), per_pass(settings.per_pass) {}
+
+    bool AdmissionLane::push(
+        BinaryBuffer& datagram, const detail::IPV4Addr& address, uint64_t received_us
+    ) {
+        if (this->count == this->ring.size()) {
+            return false;
+        }
+
+        auto& pending       = this->ring[(this->head + this->count) % this->ring.size()];
+        pending.datagram    = std::move(datagram);
+        pending.address     = address;
+        pending.received_us = received_us;
+
+        this->count++;
+        return true;
+    }
+} // namespace rakro
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "rakro/internal/binary_buffer.hpp"
+#include "rakro/internal/net.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rakro {
+
+    struct AdmissionSettings {
+        // Unconnected datagrams that can wait for their turn, new ones are dropped past this.
+        // Each of them holds a rented buffer, so keep it well under rented_buffer_count
+        size_t queue_capacity = 128;
+        // Handled per pass of the listener, only once every connected datagram of that pass
+        // was routed. 0 handles the whole queue every pass
+        size_t per_pass = 16;
+    };
+
+    // The two ways a datagram can go once it left the socket
+    enum class IngressLane : uint8_t { Connected, Unconnected };
+
+    constexpr size_t INGRESS_LANE_COUNT = 2;
+
+    struct LaneStats {
+        uint64_t handled{0};
+        uint64_t dropped{0}; // Unconnected only, the admission queue was full
+        // From leaving the socket to being routed to a worker, or answered for unconnected
+        // ones. Connected datagrams still wait on their worker after this
+        uint64_t total_latency_us{0};
+        uint64_t max_latency_us{0};
+    };
+
+    // One lane's stats, written by the listener thread only and read from anywhere
+    class LaneCounters {
+    public:
+        void record(uint64_t received_us, uint64_t now_us) noexcept {
+            const auto latency = now_us - received_us;
+
+            bump(this->handled, 1);
+            bump(this->total_latency_us, latency);
+
+            if (latency > this->max_latency_us.load(std::memory_order_relaxed)) {
+                this->max_latency_us.store(latency, std::memory_order_relaxed);
+            }
+        }
+
+        void drop() noexcept { bump(this->dropped, 1); }
+
+        LaneStats get() const noexcept {
+            return LaneStats{
+                .handled          = this->handled.load(std::memory_order_relaxed),
+                .dropped          = this->dropped.load(std::memory_order_relaxed),
+                .total_latency_us = this->total_latency_us.load(std::memory_order_relaxed),
+                .max_latency_us   = this->max_latency_us.load(std::memory_order_relaxed),
+            };
+        }
+
+    private:
+        // Only one thread writes, so these dont need an atomic add
+        static void bump(std::atomic<uint64_t>& counter, uint64_t by) noexcept {
+            const auto value = counter.load(std::memory_order_relaxed);
+            counter.store(value + by, std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<uint64_t> handled{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> total_latency_us{0};
+        std::atomic<uint64_t> max_latency_us{0};
+    };
+
+    // Pings and handshakes waiting for the listener to get to them. They only get what is
+    // left of a pass after connected traffic was routed, so a ping storm or a login wave
+    // queues up here rather than in front of players that are already in. Listener thread
+    // only, it is a plain ring of capacity slots allocated once
+    class AdmissionLane {
+    public:
+        explicit AdmissionLane(AdmissionSettings settings);
+        AdmissionLane(const AdmissionLane&) = delete;
+
+        // False if it was full, datagram is left as it was then
+        bool
+        push(BinaryBuffer& datagram, const detail::IPV4Addr& address, uint64_t received_us);
+
+        // Calls handle(datagram, address, received_us) for up to per_pass of the oldest ones,
+        // and hands their buffers back afterwards. Returns how many it went through
+        template <typename Handle> size_t drain(Handle&& handle) {
+            const auto max   = this->per_pass == 0 ? this->count : this->per_pass;
+            size_t     taken = 0;
+
+            for (; taken < max && this->count != 0; taken++) {
+                auto& pending = this->ring[this->head];
+
+                handle(pending.datagram, pending.address, pending.received_us);
+                pending.datagram = BinaryBuffer();
+
+                this->head = (this->head + 1) % this->ring.size();
+                this->count--;
+            }
+            return taken;
+        }
+
+        bool   empty() const noexcept { return this->count == 0; }
+        size_t size() const noexcept { return this->count; }
+
+    private:
+        struct Pending {
+            BinaryBuffer     datagram{};
+            detail::IPV4Addr address{};
+            uint64_t         received_us{0};
+        };
+
+    private:
+        std::vector<Pending> ring{};
+        size_t               head{0};
+        size_t               count{0};
+        size_t               per_pass{0};
+    };
+} // namespace rakro
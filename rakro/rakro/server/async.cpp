@@ -0,0 +1,263 @@
+#include "async.hpp"
+#include "server.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace rakro {
+
+    SessionTask::promise_type::~promise_type() {
+        if (this->owner != nullptr) {
+            this->owner->unlink(*this);
+        }
+    }
+
+    bool AsyncConnection::ReceiveAwaiter::await_ready() const noexcept {
+        return !this->state->inbox.empty() || !this->state->open;
+    }
+
+    void AsyncConnection::ReceiveAwaiter::await_suspend(std::coroutine_handle<> waiting) {
+        if (this->state->receiver) {
+            throw std::logic_error("Only one receive at a time per connection");
+        }
+        this->state->receiver = waiting;
+    }
+
+    std::optional<ReceivedMessage> AsyncConnection::ReceiveAwaiter::await_resume() {
+        if (this->state->inbox.empty()) {
+            return std::nullopt;
+        }
+
+        auto message = std::move(this->state->inbox.front());
+        this->state->inbox.pop_front();
+        return message;
+    }
+
+    bool AsyncConnection::SendAwaiter::await_ready() const noexcept {
+        return !this->state->open;
+    }
+
+    bool AsyncConnection::SendAwaiter::await_suspend(std::coroutine_handle<> waiting) {
+        this->waiting = waiting;
+
+        // Not queued, so nothing will ever resume us, go on right away with acked unset
+        if (!this->server->send_with_receipt(*this)) {
+            return false;
+        }
+
+        this->state->sends.push_back(this);
+        return true;
+    }
+
+    ClientHandle AsyncConnection::handle() const noexcept {
+        return this->state != nullptr ? this->state->client : ClientHandle{};
+    }
+
+    bool AsyncConnection::is_open() const noexcept {
+        return this->state != nullptr && this->state->open;
+    }
+
+    bool AsyncConnection::send(
+        std::span<const uint8_t> payload, packets::FrameReliability rely, uint8_t channel,
+        SendPriority priority
+    ) {
+        if (!this->is_open()) {
+            return false;
+        }
+        return this->server->server.send(this->state->client, payload, rely, channel, priority);
+    }
+
+    bool AsyncServer::AcceptAwaiter::await_ready() const noexcept {
+        return !this->server->unaccepted.empty();
+    }
+
+    void AsyncServer::AcceptAwaiter::await_suspend(std::coroutine_handle<> waiting) {
+        this->waiting = waiting;
+        this->server->acceptors.push_back(this);
+    }
+
+    AsyncConnection AsyncServer::AcceptAwaiter::await_resume() {
+        if (this->accepted.has_value()) {
+            return std::move(*this->accepted);
+        }
+
+        auto connection = std::move(this->server->unaccepted.front());
+        this->server->unaccepted.pop_front();
+        return connection;
+    }
+
+    AsyncServer::AsyncServer(RakServer& server, size_t poll_batch)
+        : server(server), events(std::max(poll_batch, size_t{1})) {}
+
+    AsyncServer::~AsyncServer() {
+        // Destroying a frame unlinks it, so this always takes the next one
+        while (this->sessions != nullptr) {
+            std::coroutine_handle<SessionTask::promise_type>::from_promise(*this->sessions)
+                .destroy();
+        }
+    }
+
+    void AsyncServer::spawn(SessionTask task) {
+        const auto handle = std::exchange(task.handle, nullptr);
+        if (!handle) {
+            return;
+        }
+
+        this->link(handle.promise());
+        handle.resume();
+    }
+
+    size_t AsyncServer::pump() {
+        const auto count = this->server.poll(this->events);
+
+        for (size_t index = 0; index < count; index++) {
+            const auto& event = this->events[index];
+
+            switch (event.type) {
+            case EventType::Connected: {
+                this->on_connected(event);
+                break;
+            }
+            case EventType::Disconnected: {
+                this->on_disconnected(event);
+                break;
+            }
+            case EventType::Message: {
+                this->on_message(event);
+                break;
+            }
+            case EventType::Receipt: {
+                this->on_receipt(event);
+                break;
+            }
+            }
+        }
+        return count;
+    }
+
+    void AsyncServer::on_connected(const Event& event) {
+        auto state    = std::make_shared<AsyncConnectionState>();
+        state->client = event.client;
+
+        this->connections[event.client.address.packed()] = state;
+
+        auto connection = AsyncConnection(this, std::move(state));
+
+        if (this->acceptors.empty()) {
+            this->unaccepted.push_back(std::move(connection));
+            return;
+        }
+
+        auto* acceptor = this->acceptors.front();
+        this->acceptors.pop_front();
+
+        acceptor->accepted = std::move(connection);
+        acceptor->waiting.resume();
+    }
+
+    void AsyncServer::on_disconnected(const Event& event) {
+        const auto entry = this->connections.find(event.client.address.packed());
+        if (entry == this->connections.end()) {
+            return;
+        }
+
+        // Kept alive here, the sessions we resume might drop their last copy
+        const auto state = std::move(entry->second);
+        this->connections.erase(entry);
+
+        state->open   = false;
+        state->reason = event.reason;
+
+        for (auto* send : std::exchange(state->sends, {})) {
+            this->receipts.erase(send->receipt);
+            send->waiting.resume();
+        }
+
+        // Anything still in the inbox is handed out first
+        if (state->receiver && state->inbox.empty()) {
+            std::exchange(state->receiver, nullptr).resume();
+        }
+    }
+
+    void AsyncServer::on_message(const Event& event) {
+        const auto entry = this->connections.find(event.client.address.packed());
+        if (entry == this->connections.end()) {
+            return; // Sent before NewIncomingConnection, nobody could have accepted it yet
+        }
+
+        // The payload is only valid until the next poll, sessions might hold on to it longer
+        const auto state = entry->second;
+        state->inbox.push_back(ReceivedMessage{
+            .channel = event.channel,
+            .payload = std::vector<uint8_t>(event.payload.begin(), event.payload.end()),
+        });
+
+        if (state->receiver) {
+            std::exchange(state->receiver, nullptr).resume();
+        }
+    }
+
+    void AsyncServer::on_receipt(const Event& event) {
+        const auto entry = this->receipts.find(event.receipt.receipt);
+        if (entry == this->receipts.end()) {
+            return;
+        }
+
+        auto* send = entry->second;
+        this->receipts.erase(entry);
+        std::erase(send->state->sends, send);
+
+        send->acked = event.receipt.status == ReceiptStatus::Acked;
+        send->waiting.resume();
+    }
+
+    bool AsyncServer::send_with_receipt(AsyncConnection::SendAwaiter& send) {
+        // 0 is left out, so a receipt of 0 is never one of ours
+        if (this->next_receipt == 0) {
+            this->next_receipt++;
+        }
+        send.receipt = this->next_receipt++;
+
+        const auto message = OutgoingMessage{
+            .client   = send.state->client,
+            .payload  = send.payload,
+            .rely     = packets::FrameReliability::ReliableOrderedWithAckReceipt,
+            .channel  = send.channel,
+            .priority = SendPriority::Medium,
+            .receipt  = send.receipt,
+        };
+
+        if (this->server.send(std::span(&message, 1)) != 1) {
+            return false;
+        }
+
+        this->receipts[send.receipt] = &send;
+        return true;
+    }
+
+    void AsyncServer::link(SessionTask::promise_type& session) noexcept {
+        session.owner    = this;
+        session.previous = nullptr;
+        session.next     = this->sessions;
+
+        if (this->sessions != nullptr) {
+            this->sessions->previous = &session;
+        }
+        this->sessions = &session;
+        this->session_count++;
+    }
+
+    void AsyncServer::unlink(SessionTask::promise_type& session) noexcept {
+        if (session.previous != nullptr) {
+            session.previous->next = session.next;
+        } else {
+            this->sessions = session.next;
+        }
+
+        if (session.next != nullptr) {
+            session.next->previous = session.previous;
+        }
+
+        session.owner = nullptr;
+        this->session_count--;
+    }
+} // namespace rakro
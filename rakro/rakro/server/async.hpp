@@ -0,0 +1,243 @@
+#pragma once
+
+#include "rakro/internal/coroutine_pool.hpp"
+#include "rakro/server/events.hpp"
+#include "rakro/server/outbox.hpp"
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace rakro {
+
+    class RakServer;
+    class AsyncServer;
+
+    // A coroutine for AsyncServer::spawn, it only starts once spawned and frees itself when
+    // it returns. Like a thread, an exception escaping one ends the process
+    class SessionTask {
+    public:
+        struct promise_type {
+            promise_type() = default;
+            promise_type(const promise_type&) = delete;
+            ~promise_type();
+
+            SessionTask get_return_object() noexcept {
+                return SessionTask(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_never  final_suspend() noexcept { return {}; }
+            void                return_void() noexcept {}
+            void                unhandled_exception() noexcept { std::terminate(); }
+
+            static void* operator new(size_t size) {
+                return CoroutineFramePool::local().allocate(size);
+            }
+            static void operator delete(void* frame, size_t size) noexcept {
+                CoroutineFramePool::local().deallocate(frame, size);
+            }
+
+            // Every running session of an AsyncServer, so it can clean up after them
+            AsyncServer*  owner{nullptr};
+            promise_type* previous{nullptr};
+            promise_type* next{nullptr};
+        };
+
+        SessionTask(SessionTask&& other) noexcept
+            : handle(std::exchange(other.handle, nullptr)) {}
+        SessionTask(const SessionTask&) = delete;
+        // Only does anything if it was never spawned
+        ~SessionTask() {
+            if (this->handle) {
+                this->handle.destroy();
+            }
+        }
+
+    private:
+        explicit SessionTask(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+    private:
+        std::coroutine_handle<promise_type> handle{};
+
+        friend class AsyncServer;
+    };
+
+    struct ReceivedMessage {
+        uint8_t              channel{0};
+        std::vector<uint8_t> payload{}; // Owned, unlike Event::payload
+    };
+
+    struct AsyncConnectionState;
+
+    // One connection as a session sees it, cheap to copy. Awaiting only ever resumes on the
+    // thread calling AsyncServer::pump
+    class AsyncConnection {
+    public:
+        class ReceiveAwaiter {
+        public:
+            bool await_ready() const noexcept;
+            void await_suspend(std::coroutine_handle<> waiting);
+            // nullopt once the client is gone and everything it sent was handed out
+            std::optional<ReceivedMessage> await_resume();
+
+        private:
+            explicit ReceiveAwaiter(AsyncConnectionState* state) : state(state) {}
+
+        private:
+            AsyncConnectionState* state{nullptr};
+
+            friend class AsyncConnection;
+        };
+
+        class SendAwaiter {
+        public:
+            bool await_ready() const noexcept;
+            bool await_suspend(std::coroutine_handle<> waiting);
+            // True once the client acked all of it, false if it disconnected first or the
+            // outbox was full
+            bool await_resume() const noexcept { return this->acked; }
+
+        private:
+            SendAwaiter(
+                AsyncServer* server, AsyncConnectionState* state,
+                std::span<const uint8_t> payload, uint8_t channel
+            )
+                : server(server), state(state), payload(payload), channel(channel) {}
+
+        private:
+            AsyncServer*             server{nullptr};
+            AsyncConnectionState*    state{nullptr};
+            std::span<const uint8_t> payload{};
+            uint8_t                  channel{0};
+            uint32_t                 receipt{0};
+            bool                     acked{false};
+            std::coroutine_handle<>  waiting{};
+
+            friend class AsyncConnection;
+            friend class AsyncServer;
+        };
+
+        AsyncConnection() = default;
+
+        ClientHandle handle() const noexcept;
+        bool         is_open() const noexcept;
+
+        // One receive at a time per connection
+        ReceiveAwaiter receive() { return ReceiveAwaiter(this->state.get()); }
+
+        // ReliableOrdered with an ack receipt, resumes once the client acked it. The payload
+        // is copied when the send goes out, it only has to last for the co_await
+        SendAwaiter send_reliable(std::span<const uint8_t> payload, uint8_t channel = 0) {
+            return SendAwaiter(this->server, this->state.get(), payload, channel);
+        }
+
+        // Doesnt wait for anything, false if the outbox was full or the client is gone
+        bool send(
+            std::span<const uint8_t> payload,
+            packets::FrameReliability rely     = packets::FrameReliability::ReliableOrdered,
+            uint8_t                   channel  = 0,
+            SendPriority              priority = SendPriority::Medium
+        );
+
+    private:
+        AsyncConnection(AsyncServer* server, std::shared_ptr<AsyncConnectionState> state)
+            : server(server), state(std::move(state)) {}
+
+    private:
+        AsyncServer*                          server{nullptr};
+        std::shared_ptr<AsyncConnectionState> state{};
+
+        friend class AsyncServer;
+    };
+
+    struct AsyncConnectionState {
+        ClientHandle                               client{};
+        std::deque<ReceivedMessage>                inbox{};
+        std::coroutine_handle<>                    receiver{};
+        std::vector<AsyncConnection::SendAwaiter*> sends{}; // Waiting on their receipt
+        bool                                       open{true};
+        DisconnectReason                           reason{};
+    };
+
+    // Lets sessions be written as straight line code, co_await accept, receive and
+    // send_reliable, on top of RakServer's event queue. Nothing runs on its own, pump takes
+    // the server's events and resumes whichever sessions were waiting on them, all on the
+    // calling thread, so thousands of sessions need no more than the thread pumping them.
+    //
+    // It owns the server's events, nothing else should call RakServer::poll meanwhile
+    class AsyncServer {
+    public:
+        class AcceptAwaiter {
+        public:
+            bool            await_ready() const noexcept;
+            void            await_suspend(std::coroutine_handle<> waiting);
+            AsyncConnection await_resume();
+
+        private:
+            explicit AcceptAwaiter(AsyncServer* server) : server(server) {}
+
+        private:
+            AsyncServer*                   server{nullptr};
+            std::optional<AsyncConnection> accepted{};
+            std::coroutine_handle<>        waiting{};
+
+            friend class AsyncServer;
+        };
+
+        explicit AsyncServer(RakServer& server, size_t poll_batch = 256);
+        AsyncServer(const AsyncServer&) = delete;
+        // Sessions that are still waiting on something are destroyed without being resumed
+        ~AsyncServer();
+
+        // Runs task until it first waits on something
+        void spawn(SessionTask task);
+
+        // The next client that finishes connecting, in the order they did
+        AcceptAwaiter accept() { return AcceptAwaiter(this); }
+
+        // Takes every event the server has and resumes the sessions waiting on them, returns
+        // how many events there were
+        size_t pump();
+
+        size_t get_session_count() const noexcept { return this->session_count; }
+        size_t get_connection_count() const noexcept { return this->connections.size(); }
+
+    private:
+        void on_connected(const Event& event);
+        void on_disconnected(const Event& event);
+        void on_message(const Event& event);
+        void on_receipt(const Event& event);
+
+        // Queues send's payload with a fresh receipt, false if the outbox was full
+        bool send_with_receipt(AsyncConnection::SendAwaiter& send);
+
+        void link(SessionTask::promise_type& session) noexcept;
+        void unlink(SessionTask::promise_type& session) noexcept;
+
+    private:
+        RakServer&                  server;
+        std::vector<Event>          events{};
+        std::deque<AsyncConnection> unaccepted{};
+        std::deque<AcceptAwaiter*>  acceptors{};
+
+        // By packed address, only the ones still connected
+        std::unordered_map<uint64_t, std::shared_ptr<AsyncConnectionState>> connections{};
+        std::unordered_map<uint32_t, AsyncConnection::SendAwaiter*>         receipts{};
+        uint32_t                                                            next_receipt{1};
+
+        SessionTask::promise_type* sessions{nullptr};
+        size_t                     session_count{0};
+
+        friend class AsyncConnection;
+        friend class AsyncConnection::SendAwaiter;
+        friend struct SessionTask::promise_type;
+    };
+} // namespace rakro
@@ -0,0 +1,187 @@
+#include "congestion.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace rakro {
+
+    namespace {
+        class SlidingWindow final : public ICongestionControl {
+        public:
+            SlidingWindow(size_t mss, size_t max_window)
+                : mss(mss), max_window(max_window),
+                  window(std::min(mss * INITIAL_WINDOW_SEGMENTS, max_window)),
+                  threshold(max_window) {}
+
+            void on_ack(uint64_t, size_t bytes, uint64_t srtt) override {
+                this->srtt = srtt;
+
+                if (this->in_slow_start()) {
+                    this->window += bytes;
+                } else {
+                    // Adds up to one segment per window acked
+                    this->window += std::max(size_t{1}, this->mss * bytes / this->window);
+                }
+
+                this->window = std::min(this->window, this->max_window);
+            }
+
+            void on_loss(uint64_t now, uint64_t srtt) override {
+                this->srtt = srtt;
+
+                if (now < this->recovery_end) {
+                    return;
+                }
+
+                this->threshold    = this->half_window();
+                this->window       = this->threshold;
+                this->recovery_end = now + std::max(srtt, uint64_t{1});
+            }
+
+            void on_timeout(uint64_t now) override {
+                this->threshold    = this->half_window();
+                this->window       = this->mss;
+                this->recovery_end = now + std::max(this->srtt, uint64_t{1});
+            }
+
+            size_t get_window() const noexcept override { return this->window; }
+
+            bool in_slow_start() const noexcept override {
+                return this->window < this->threshold;
+            }
+
+        private:
+            size_t half_window() const noexcept {
+                return std::max(this->window / 2, this->mss * MIN_WINDOW_SEGMENTS);
+            }
+
+            size_t   mss{};
+            size_t   max_window{};
+            size_t   window{};
+            size_t   threshold{};
+            uint64_t recovery_end{0};
+            uint64_t srtt{0};
+        };
+
+        // RFC 8312, everything kept in segments and seconds like the RFC does
+        class Cubic final : public ICongestionControl {
+        public:
+            static constexpr double C    = 0.4;
+            static constexpr double BETA = 0.7;
+
+            Cubic(size_t mss, size_t max_window)
+                : mss(mss), max_window(max_window),
+                  window(std::min(
+                      static_cast<double>(INITIAL_WINDOW_SEGMENTS),
+                      static_cast<double>(max_window / mss)
+                  )) {}
+
+            void on_ack(uint64_t now, size_t bytes, uint64_t srtt) override {
+                this->srtt = srtt;
+
+                const auto acked = static_cast<double>(bytes) / static_cast<double>(this->mss);
+
+                if (this->in_slow_start()) {
+                    this->window = std::min(this->window + acked, this->max_segments());
+                    return;
+                }
+
+                if (this->epoch_start == 0) {
+                    this->epoch_start = now;
+                    this->k           = this->window < this->last_max
+                                            ? std::cbrt((this->last_max - this->window) / C)
+                                            : 0.0;
+                    this->origin      = std::max(this->window, this->last_max);
+                    this->tcp_window  = this->window;
+                }
+
+                // Where the curve will be one round trip from now
+                const auto t = static_cast<double>(now + srtt - this->epoch_start) / 1000.0;
+                auto target  = C * std::pow(t - this->k, 3.0) + this->origin;
+
+                // Never slower than plain additive increase would be
+                this->tcp_window += 3.0 * (1.0 - BETA) / (1.0 + BETA) * acked / this->window;
+                target = std::max(target, this->tcp_window);
+
+                if (target > this->window) {
+                    // At most 1.5x per round trip, like everyone else caps it
+                    const auto step = std::min(target - this->window, this->window / 2.0);
+                    this->window += step * acked / this->window;
+                }
+
+                this->window = std::min(this->window, this->max_segments());
+            }
+
+            void on_loss(uint64_t now, uint64_t srtt) override {
+                this->srtt = srtt;
+
+                if (now < this->recovery_end) {
+                    return;
+                }
+
+                this->reduce();
+                this->window       = this->threshold;
+                this->recovery_end = now + std::max(srtt, uint64_t{1});
+            }
+
+            void on_timeout(uint64_t now) override {
+                this->reduce();
+                this->window       = 1.0;
+                this->recovery_end = now + std::max(this->srtt, uint64_t{1});
+            }
+
+            size_t get_window() const noexcept override {
+                return static_cast<size_t>(this->window * static_cast<double>(this->mss));
+            }
+
+            bool in_slow_start() const noexcept override {
+                return this->window < this->threshold;
+            }
+
+        private:
+            double max_segments() const noexcept {
+                return static_cast<double>(this->max_window / this->mss);
+            }
+
+            void reduce() noexcept {
+                // Fast convergence, a flow losing again below its last peak gives some of its
+                // share up to newer ones
+                this->last_max = this->window < this->last_max
+                                     ? this->window * (1.0 + BETA) / 2.0
+                                     : this->window;
+
+                this->threshold =
+                    std::max(this->window * BETA, static_cast<double>(MIN_WINDOW_SEGMENTS));
+                this->epoch_start = 0;
+            }
+
+            size_t   mss{};
+            size_t   max_window{};
+            double   window{};
+            double   threshold{std::numeric_limits<double>::max()};
+            double   last_max{0.0};
+            double   origin{0.0};
+            double   tcp_window{0.0};
+            double   k{0.0};
+            uint64_t epoch_start{0};
+            uint64_t recovery_end{0};
+            uint64_t srtt{0};
+        };
+    } // namespace
+
+    std::unique_ptr<ICongestionControl>
+    make_congestion_control(CongestionAlgorithm algorithm, size_t mss, size_t max_window) {
+        // Never below the floor the algorithms themselves keep to
+        max_window = std::clamp(max_window, mss * MIN_WINDOW_SEGMENTS, MAX_CONGESTION_WINDOW);
+
+        switch (algorithm) {
+        case CongestionAlgorithm::Cubic: {
+            return std::make_unique<Cubic>(mss, max_window);
+        }
+        case CongestionAlgorithm::SlidingWindow:
+        default: {
+            return std::make_unique<SlidingWindow>(mss, max_window);
+        }
+        }
+    }
+} // namespace rakro
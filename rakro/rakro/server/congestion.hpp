@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace rakro {
+
+    // Windows are in bytes, MSS being the biggest frame set a connection sends
+    constexpr size_t INITIAL_WINDOW_SEGMENTS = 4;
+    constexpr size_t MIN_WINDOW_SEGMENTS     = 2;
+    constexpr size_t MAX_CONGESTION_WINDOW   = size_t{1} << 23;
+
+    // How much unused pacing budget may pile up, in ms worth of the pacing rate
+    constexpr uint64_t PACING_BURST_MS = 20;
+    // Pacing gain in percent, slow start runs ahead of the window so it can keep doubling
+    constexpr uint64_t SLOW_START_PACING_GAIN = 200;
+    constexpr uint64_t PACING_GAIN            = 125;
+
+    enum class CongestionAlgorithm : uint8_t {
+        // What RakNet itself does, slow start then one segment per window acked
+        SlidingWindow,
+        // Cubic growth around the window of the last loss, gets back up to speed a lot
+        // quicker on high latency links
+        Cubic,
+    };
+
+    struct CongestionStats {
+        size_t   window{};      // Bytes allowed in flight
+        size_t   in_flight{};   // Reliable bytes sent and not acked yet
+        uint64_t pacing_rate{}; // Bytes per second, 0 until the first RTT sample
+        uint64_t srtt{};
+        uint64_t rto{};
+        size_t   queued{};        // Datagrams waiting on the window or the pacer
+        size_t   queued_frames{}; // Frames waiting on their priority to be packed
+    };
+
+    class ICongestionControl {
+    public:
+        // bytes is how much the ack took out of flight, srtt the estimate including it
+        virtual void on_ack(uint64_t now, size_t bytes, uint64_t srtt) = 0;
+
+        // The client nacked something. Only the first loss in a round trip shrinks the
+        // window, the rest are usually the same burst
+        virtual void on_loss(uint64_t now, uint64_t srtt) = 0;
+
+        // A retransmit timer fired, the link might be gone entirely
+        virtual void on_timeout(uint64_t now) = 0;
+
+        virtual size_t get_window() const noexcept    = 0;
+        virtual bool   in_slow_start() const noexcept = 0;
+
+        virtual ~ICongestionControl() {}
+    };
+
+    // max_window caps the window below MAX_CONGESTION_WINDOW, see RakroServerClient
+    std::unique_ptr<ICongestionControl> make_congestion_control(
+        CongestionAlgorithm algorithm, size_t mss, size_t max_window = MAX_CONGESTION_WINDOW
+    );
+
+    // Token bucket spreading a window of datagrams over the round trip, instead of handing
+    // the whole thing to the socket at once
+    class Pacer {
+    public:
+        // 0 turns pacing off
+        void set_rate(uint64_t bytes_per_second) noexcept { this->rate = bytes_per_second; }
+        uint64_t get_rate() const noexcept { return this->rate; }
+
+        // A datagram may go out as long as there is any budget left, the budget can go
+        // negative by one datagram that way, which the next refill pays back
+        bool can_send(uint64_t now) noexcept {
+            if (this->rate == 0) {
+                return true;
+            }
+
+            // Anything past the burst would be capped anyway, and it keeps the refill below
+            // from overflowing after a long idle
+            const auto elapsed = std::min(now - this->last_refill, PACING_BURST_MS);
+            this->last_refill  = now;
+
+            const auto burst = static_cast<int64_t>(this->rate * PACING_BURST_MS);
+            this->budget =
+                std::min(this->budget + static_cast<int64_t>(this->rate * elapsed), burst);
+
+            return this->budget > 0;
+        }
+
+        void on_send(size_t bytes) noexcept {
+            if (this->rate != 0) {
+                this->budget -= static_cast<int64_t>(bytes) * 1000;
+            }
+        }
+
+    private:
+        uint64_t rate{0};
+        uint64_t last_refill{0};
+        // In thousandths of a byte so slow links dont lose their budget to rounding
+        int64_t budget{0};
+    };
+} // namespace rakro
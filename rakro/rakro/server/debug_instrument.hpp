@@ -2,6 +2,8 @@
 
 #include "rakro/packet/frame_set.hpp"
 #include "rakro/packet/packet_id.hpp"
+#include "rakro/server/congestion.hpp"
+#include "rakro/server/receipts.hpp"
 #include <cstdint>
 #include <print>
 #include <rakro/internal/net.hpp>
@@ -32,9 +34,20 @@ namespace rakro {
             return true;
         }
 
+        // Only for clients that arent owned by a router, everything else goes out through the
+        // router's events
         [[maybe_unused]] virtual void
         unhandled_client_packet(std::span<uint8_t> data, detail::IPV4Addr& address) {}
 
+        // Whenever a client with something in flight or queued is updated, every tick while
+        // something is queued, otherwise at its retransmit deadlines
+        [[maybe_unused]] virtual void
+        on_congestion_stats(const CongestionStats& stats, detail::IPV4Addr& address) {}
+
+        // Next tick for every client with receipts that were acked or lost since the last
+        [[maybe_unused]] virtual void
+        on_receipts(std::span<const ReceiptEvent> receipts, detail::IPV4Addr& address) {}
+
         virtual ~IRakServerDebugInstrument() {}
     };
 
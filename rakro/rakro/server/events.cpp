@@ -0,0 +1,110 @@
+#include "events.hpp"
+#include <bit>
+#include <cstring>
+#include <utility>
+
+namespace rakro {
+
+    EventChannel::EventChannel(
+        size_t queue_capacity, size_t ring_capacity, size_t backlog_capacity,
+        size_t backlog_bytes
+    )
+        : queue(queue_capacity),
+          ring(std::make_unique_for_overwrite<uint8_t[]>(std::bit_ceil(ring_capacity))),
+          ring_capacity(std::bit_ceil(ring_capacity)), max_backlog(backlog_capacity),
+          max_backlog_bytes(backlog_bytes) {}
+
+    bool EventChannel::push(Event&& event, std::span<const uint8_t> payload) {
+        // Anything in the backlog has to go first, or events of a client would be reordered
+        if (this->backlog.empty() && this->try_publish(event, payload)) {
+            return true;
+        }
+
+        const auto full = this->backlog.size() >= this->max_backlog ||
+                          this->backlog_bytes + payload.size() > this->max_backlog_bytes;
+
+        if (full && event.type == EventType::Message) {
+            this->dropped.store(
+                this->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed
+            );
+            return false;
+        }
+
+        if (!payload.empty()) {
+            event.spilled_payload.assign(payload.begin(), payload.end());
+        }
+        this->backlog_bytes += payload.size();
+        this->backlog.push_back(std::move(event));
+        return true;
+    }
+
+    void EventChannel::flush() {
+        while (!this->backlog.empty()) {
+            // Already has its own copy, the ring is left to events that didnt spill
+            auto&      event = this->backlog.front();
+            const auto size  = event.spilled_payload.size();
+            event.payload    = event.spilled_payload;
+
+            if (!this->try_publish(event, {})) {
+                return;
+            }
+            this->backlog_bytes -= size;
+            this->backlog.pop_front();
+        }
+    }
+
+    size_t EventChannel::poll(std::span<Event> out) {
+        // Whatever the last poll handed out is done with now
+        this->ring_read.store(this->released_to, std::memory_order_release);
+
+        size_t count = 0;
+        while (count < out.size()) {
+            auto queued = this->queue.try_pop();
+            if (!queued.has_value()) {
+                break;
+            }
+
+            this->released_to = queued->ring_end;
+            out[count++]      = std::move(queued->event);
+        }
+        return count;
+    }
+
+    bool EventChannel::try_publish(Event& event, std::span<const uint8_t> payload) {
+        const auto size = payload.size();
+        if (size > this->ring_capacity / 2) {
+            return false; // Would never fit, the backlog copy goes through on the next flush
+        }
+
+        // Payloads are never split over the end of the ring, the tail is skipped instead
+        auto       start  = this->ring_write;
+        const auto offset = start & (this->ring_capacity - 1);
+        if (offset + size > this->ring_capacity) {
+            start += this->ring_capacity - offset;
+        }
+        const auto end = start + size;
+
+        if (end - this->cached_read > this->ring_capacity) {
+            this->cached_read = this->ring_read.load(std::memory_order_acquire);
+            if (end - this->cached_read > this->ring_capacity) {
+                return false;
+            }
+        }
+
+        auto queued = QueuedEvent{.event = std::move(event), .ring_end = end};
+
+        if (size != 0) {
+            auto* bytes = this->ring.get() + (start & (this->ring_capacity - 1));
+            std::memcpy(bytes, payload.data(), size);
+            queued.event.payload = std::span<const uint8_t>(bytes, size);
+        }
+
+        if (!this->queue.try_push(std::move(queued))) {
+            event = std::move(queued.event);
+            return false;
+        }
+
+        this->ring_write = end;
+        return true;
+    }
+} // namespace rakro
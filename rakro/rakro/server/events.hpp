@@ -0,0 +1,118 @@
+#pragma once
+
+#include "rakro/internal/net.hpp"
+#include "rakro/internal/spsc_queue.hpp"
+#include "rakro/server/receipts.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace rakro {
+
+    // Events one router can have waiting for the game before new ones go to its backlog
+    constexpr size_t EVENT_QUEUE_CAPACITY = 4096;
+    // Payload bytes one router can have waiting, messages are copied in here
+    constexpr size_t EVENT_RING_CAPACITY = size_t{1} << 20;
+    // How far the backlog grows once the game stops keeping up, in events and in payload
+    // bytes. Past either, new messages are dropped
+    constexpr size_t EVENT_BACKLOG_CAPACITY = size_t{1} << 14;
+    constexpr size_t EVENT_BACKLOG_BYTES    = size_t{8} << 20;
+
+    enum class EventType : uint8_t {
+        Connected, // NewIncomingConnection came in, the client is ready for game packets
+        Disconnected,
+        Message,
+        Receipt, // Acked or lost, for frames sent with a WithAckReceipt reliability
+    };
+
+    enum class DisconnectReason : uint8_t {
+        TimedOut,
+        Requested,  // The client sent DisconnectionNotification
+        Misbehaved, // Sent something it could never get through, like a malformed split packet
+    };
+
+    // What a game uses to tell its connections apart. The guid is the one the client sent in
+    // ConnectionRequest, 0 before that
+    struct ClientHandle {
+        detail::IPV4Addr address{};
+        uint64_t         guid{0};
+    };
+
+    struct Event {
+        EventType    type{EventType::Message};
+        ClientHandle client{};
+        // Message only, the ordering channel it came in on, 0 if it wasnt ordered
+        uint8_t channel{0};
+        // Message only. Game packets if the payload pipeline is on, otherwise the whole frame
+        // body starting at its packet id. Only valid until the next poll
+        std::span<const uint8_t> payload{};
+        ReceiptEvent             receipt{};          // Receipt only
+        DisconnectReason         reason{};           // Disconnected only
+        std::vector<uint8_t>     spilled_payload{}; // Only used if the ring was full
+    };
+
+    // Hands events from one router to the game thread without locking. Events go through an
+    // SPSC queue, message payloads are copied into a byte ring next to it. The game releases
+    // the payloads it was handed by polling again, so they stay put until then.
+    //
+    // When the queue or the ring is full, events wait in a backlog on the router's side with
+    // their own copy of the payload and are retried every tick. The backlog is bounded, once
+    // it is full messages are dropped and counted rather than letting a client grow memory
+    // for as long as the game isnt polling. Connections, disconnections and receipts are
+    // always kept, there are only ever as many of those as clients and sends
+    class EventChannel {
+    public:
+        explicit EventChannel(
+            size_t queue_capacity   = EVENT_QUEUE_CAPACITY,
+            size_t ring_capacity    = EVENT_RING_CAPACITY,
+            size_t backlog_capacity = EVENT_BACKLOG_CAPACITY,
+            size_t backlog_bytes    = EVENT_BACKLOG_BYTES
+        );
+        EventChannel(const EventChannel&) = delete;
+
+        // Router thread only. False if it was a message and the backlog was full
+        bool push(Event&& event, std::span<const uint8_t> payload = {});
+        // Retries the backlog, router thread only
+        void flush();
+
+        // Game thread only, returns how many of out were filled
+        size_t poll(std::span<Event> out);
+
+        // Messages push turned away so far, from any thread
+        uint64_t get_dropped() const noexcept {
+            return this->dropped.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct QueuedEvent {
+            Event    event{};
+            uint64_t ring_end{0}; // Ring position the payload ends at, padding included
+        };
+
+        // Copies payload into the ring and queues the event, leaves both alone on failure
+        bool try_publish(Event& event, std::span<const uint8_t> payload);
+
+    private:
+        SpscQueue<QueuedEvent>     queue;
+        std::unique_ptr<uint8_t[]> ring{};
+        size_t                     ring_capacity{};
+
+        // Router side
+        uint64_t          ring_write{0};
+        uint64_t          cached_read{0};
+        std::deque<Event> backlog{};
+        size_t            backlog_bytes{0}; // Spilled payloads in it
+        size_t            max_backlog{};
+        size_t            max_backlog_bytes{};
+
+        std::atomic<uint64_t> dropped{0}; // Only the router writes
+
+        // Game side
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> ring_read{0};
+        uint64_t released_to{0}; // Where ring_read goes on the next poll
+    };
+} // namespace rakro
@@ -0,0 +1,179 @@
+#include "fragments.hpp"
+#include <cstring>
+#include <utility>
+
+namespace rakro {
+
+    std::expected<std::optional<ReassembledFrame>, FragmentError> FragmentAssembler::add(
+        const packets::FrameInfo& info, std::span<const uint8_t> body, uint64_t now
+    ) {
+        const auto slot = this->find_or_start(info, now);
+
+        if (!slot.has_value()) {
+            return std::unexpected(slot.error());
+        }
+
+        auto&       compound = this->compounds[slot.value()];
+        const auto& fragment = info.fragment_info.value();
+        const auto  index    = fragment.fragment_index;
+
+        if (fragment.fragment_size != compound.count || index >= compound.count ||
+            body.empty() || body.size() > this->max_fragment_size) {
+            this->drop(slot.value());
+            return std::unexpected(FragmentError::Malformed);
+        }
+
+        compound.last_activity = now;
+
+        auto&      arrived = compound.arrived[index / 64];
+        const auto bit     = uint64_t{1} << (index % 64);
+
+        if (arrived & bit) {
+            return std::nullopt; // A resend of something we already have
+        }
+
+        if (!this->place(compound, index, body)) {
+            this->drop(slot.value());
+            return std::unexpected(FragmentError::Malformed);
+        }
+
+        arrived |= bit;
+        compound.received++;
+
+        if (compound.received != compound.count) {
+            return std::nullopt;
+        }
+
+        auto frame = ReassembledFrame{
+            .memory = std::move(compound.memory),
+            .size   = size_t{compound.count - 1} * compound.stride + compound.last_size,
+            .info   = compound.info
+        };
+        frame.info.fragment_info.reset();
+
+        this->drop(slot.value());
+        return frame;
+    }
+
+    void FragmentAssembler::expire(uint64_t now) {
+        for (size_t index = this->compounds.size(); index-- > 0;) {
+            if (now - this->compounds[index].last_activity > COMPOUND_TIMEOUT) {
+                this->drop(index);
+            }
+        }
+    }
+
+    std::expected<size_t, FragmentError>
+    FragmentAssembler::find_or_start(const packets::FrameInfo& info, uint64_t now) {
+        const auto& fragment = info.fragment_info.value();
+
+        // Never more than a handful, a linear walk beats hashing here
+        for (size_t index = 0; index < this->compounds.size(); index++) {
+            if (this->compounds[index].id == fragment.fragment_compound_id) {
+                return index;
+            }
+        }
+
+        if (fragment.fragment_size == 0) {
+            return std::unexpected(FragmentError::Malformed);
+        }
+
+        if (fragment.fragment_size > MAX_FRAGMENT_COUNT) {
+            return std::unexpected(FragmentError::TooManyFragments);
+        }
+
+        if (this->compounds.size() >= MAX_COMPOUNDS) {
+            return std::unexpected(FragmentError::TooManyCompounds);
+        }
+
+        // Sized for the biggest fragments the MTU allows, the real size is only known once
+        // the last one arrives
+        const auto reserve = size_t{fragment.fragment_size} * this->max_fragment_size;
+
+        if (reserve > MAX_REASSEMBLY_BYTES) {
+            return std::unexpected(FragmentError::TooLarge);
+        }
+
+        if (this->reserved_bytes + reserve > MAX_REASSEMBLY_BYTES) {
+            return std::unexpected(FragmentError::NoRoom);
+        }
+
+        // Held to the server wide budget, so many connections reassembling at once cant run
+        // the process out of memory
+        auto memory = this->pool->try_rent(reserve);
+        if (!memory) {
+            return std::unexpected(FragmentError::NoRoom);
+        }
+
+        auto& compound = this->compounds.emplace_back();
+
+        compound.id            = fragment.fragment_compound_id;
+        compound.count         = fragment.fragment_size;
+        compound.last_activity = now;
+        compound.reserved      = reserve;
+        compound.memory        = std::move(memory);
+        compound.info          = info;
+        compound.arrived.resize((compound.count + 63) / 64);
+
+        this->reserved_bytes += reserve;
+        return this->compounds.size() - 1;
+    }
+
+    bool FragmentAssembler::place(
+        Compound& compound, uint32_t index, std::span<const uint8_t> body
+    ) {
+        const auto write_at = [&](uint32_t at, std::span<const uint8_t> data) {
+            const auto offset = size_t{at} * compound.stride;
+
+            if (offset + data.size() > compound.reserved) {
+                return false;
+            }
+
+            std::memcpy(compound.memory.get_memory().data() + offset, data.data(), data.size());
+            return true;
+        };
+
+        const auto size = static_cast<uint32_t>(body.size());
+
+        if (index != compound.count - 1) {
+            if (compound.stride == 0) {
+                compound.stride = size;
+
+                // The last fragment got here first, now we know where it goes
+                if (!compound.early_tail.empty()) {
+                    if (compound.early_tail.size() > compound.stride ||
+                        !write_at(compound.count - 1, compound.early_tail)) {
+                        return false;
+                    }
+                    compound.early_tail = {};
+                }
+            } else if (size != compound.stride) {
+                return false;
+            }
+
+            return write_at(index, body);
+        }
+
+        compound.last_size = size;
+
+        if (compound.stride == 0 && compound.count > 1) {
+            compound.early_tail.assign(body.begin(), body.end());
+            return true;
+        }
+
+        if (compound.stride != 0 && size > compound.stride) {
+            return false;
+        }
+
+        return write_at(index, body);
+    }
+
+    void FragmentAssembler::drop(size_t index) noexcept {
+        this->reserved_bytes -= this->compounds[index].reserved;
+
+        if (index != this->compounds.size() - 1) {
+            this->compounds[index] = std::move(this->compounds.back());
+        }
+        this->compounds.pop_back();
+    }
+} // namespace rakro
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "rakro/internal/scratch_pool.hpp"
+#include "rakro/packet/frame_set.hpp"
+#include <cstdint>
+#include <expected>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace rakro {
+
+    // A 1400 MTU fits about 1350 bytes per fragment, so this is a bit over 5 MB
+    constexpr uint32_t MAX_FRAGMENT_COUNT = 4096;
+    // Split packets being put back together at once, per connection
+    constexpr size_t MAX_COMPOUNDS = 16;
+    // Dropped once this long passes without another fragment of it turning up
+    constexpr uint64_t COMPOUND_TIMEOUT = 10000;
+    // Everything a connection has reserved for reassembly
+    constexpr size_t MAX_REASSEMBLY_BYTES = size_t{1} << 24;
+
+    enum class FragmentError : uint8_t {
+        TooManyFragments,
+        TooManyCompounds,
+        TooLarge, // More than MAX_REASSEMBLY_BYTES on its own
+        // Index out of range, a size that doesnt match the other fragments or a fragment
+        // that disagrees with the first one about the fragment count
+        Malformed,
+        // Would go past MAX_REASSEMBLY_BYTES for the connection, or past what the scratch pool
+        // hands out to every connection together
+        NoRoom,
+    };
+
+    // Might go through if the client sends it again later, the rest never will
+    constexpr bool is_transient(FragmentError error) noexcept {
+        return error == FragmentError::TooManyCompounds || error == FragmentError::NoRoom;
+    }
+
+    // A split packet put back together, the data lives in memory until this is dropped
+    struct ReassembledFrame {
+        RentedScratch      memory{};
+        size_t             size{};
+        packets::FrameInfo info{};
+
+        std::span<uint8_t> data() noexcept {
+            return this->memory.get_memory().subspan(0, this->size);
+        }
+    };
+
+    // Every fragment is written straight to its final offset in one buffer sized for the
+    // whole packet, nothing is copied once the last one arrives.
+    //
+    // Senders split a packet into equal pieces with a shorter last one, so the offset of a
+    // fragment is its index times the size of the first non last fragment seen. A last
+    // fragment arriving before any other is the only one that has to wait in a side buffer
+    class FragmentAssembler {
+    public:
+        FragmentAssembler() = default;
+        FragmentAssembler(ScratchPool* pool, size_t max_fragment_size)
+            : pool(pool), max_fragment_size(max_fragment_size) {}
+
+        // nullopt while the packet is still missing fragments
+        std::expected<std::optional<ReassembledFrame>, FragmentError>
+        add(const packets::FrameInfo& info, std::span<const uint8_t> body, uint64_t now);
+
+        // Drops whatever stopped receiving fragments
+        void expire(uint64_t now);
+
+        size_t get_pending() const noexcept { return this->compounds.size(); }
+        size_t get_reserved_bytes() const noexcept { return this->reserved_bytes; }
+
+    private:
+        struct Compound {
+            uint16_t           id{};
+            uint32_t           count{};
+            uint32_t           received{0};
+            uint32_t           stride{0}; // Size of every fragment but the last, 0 until known
+            uint32_t           last_size{0};
+            uint64_t           last_activity{};
+            size_t             reserved{};
+            RentedScratch      memory{};
+            packets::FrameInfo info{};
+            // One bit per fragment index
+            std::vector<uint64_t> arrived{};
+            // The last fragment, if it came before the stride was known
+            std::vector<uint8_t> early_tail{};
+        };
+
+        // Index of the compound info belongs to, started if this is its first fragment
+        std::expected<size_t, FragmentError>
+        find_or_start(const packets::FrameInfo& info, uint64_t now);
+
+        bool place(Compound& compound, uint32_t index, std::span<const uint8_t> body);
+
+        void drop(size_t index) noexcept;
+
+    private:
+        ScratchPool*          pool{nullptr};
+        size_t                max_fragment_size{};
+        size_t                reserved_bytes{0};
+        std::vector<Compound> compounds{};
+    };
+} // namespace rakro
@@ -0,0 +1,144 @@
+#include "handshake.hpp"
+#include <algorithm>
+#include <bit>
+#include <random>
+
+namespace rakro {
+
+    namespace {
+        struct SipState {
+            uint64_t v0, v1, v2, v3;
+
+            void round() noexcept {
+                this->v0 += this->v1;
+                this->v1 = std::rotl(this->v1, 13) ^ this->v0;
+                this->v0 = std::rotl(this->v0, 32);
+                this->v2 += this->v3;
+                this->v3 = std::rotl(this->v3, 16) ^ this->v2;
+                this->v0 += this->v3;
+                this->v3 = std::rotl(this->v3, 21) ^ this->v0;
+                this->v2 += this->v1;
+                this->v1 = std::rotl(this->v1, 17) ^ this->v2;
+                this->v2 = std::rotl(this->v2, 32);
+            }
+
+            void absorb(uint64_t word) noexcept {
+                this->v3 ^= word;
+                this->round();
+                this->round();
+                this->v0 ^= word;
+            }
+        };
+
+        // SipHash-2-4 of exactly two words, 16 bytes of message
+        uint64_t siphash(const std::array<uint64_t, 2>& key, uint64_t a, uint64_t b) noexcept {
+            auto state = SipState{
+                .v0 = key[0] ^ 0x736f6d6570736575ull,
+                .v1 = key[1] ^ 0x646f72616e646f6dull,
+                .v2 = key[0] ^ 0x6c7967656e657261ull,
+                .v3 = key[1] ^ 0x7465646279746573ull,
+            };
+
+            state.absorb(a);
+            state.absorb(b);
+            state.absorb(uint64_t{16} << 56); // Length in the top byte, no tail left
+
+            state.v2 ^= 0xFF;
+            for (int x = 0; x < 4; x++) {
+                state.round();
+            }
+
+            return state.v0 ^ state.v1 ^ state.v2 ^ state.v3;
+        }
+    } // namespace
+
+    HandshakeCookies::HandshakeCookies() {
+        auto device = std::random_device();
+
+        for (auto& word : this->key) {
+            word = (uint64_t{device()} << 32) | device();
+        }
+    }
+
+    uint32_t
+    HandshakeCookies::issue(const detail::IPV4Addr& address, uint64_t now) const noexcept {
+        return this->make(address.packed(), now / HANDSHAKE_TIMEOUT_MS);
+    }
+
+    bool HandshakeCookies::check(
+        const detail::IPV4Addr& address, uint32_t cookie, uint64_t now
+    ) const noexcept {
+        const auto window = now / HANDSHAKE_TIMEOUT_MS;
+        const auto packed = address.packed();
+
+        return this->make(packed, window) == cookie ||
+               (window != 0 && this->make(packed, window - 1) == cookie);
+    }
+
+    uint32_t HandshakeCookies::make(uint64_t address, uint64_t window) const noexcept {
+        return static_cast<uint32_t>(siphash(this->key, address, window));
+    }
+
+    HalfOpenTable::HalfOpenTable(size_t capacity) {
+        const auto sets = std::bit_ceil(std::max(capacity / WAYS, size_t{1}));
+
+        this->entries.resize(sets * WAYS);
+        this->set_bits = static_cast<size_t>(std::countr_zero(sets));
+    }
+
+    void HalfOpenTable::insert(
+        const detail::IPV4Addr& address, uint16_t mtu, uint64_t now
+    ) noexcept {
+        const auto key   = address.packed();
+        const auto first = this->set_of(key);
+
+        auto* target = &this->entries[first];
+
+        for (size_t way = 0; way < WAYS; way++) {
+            auto& entry = this->entries[first + way];
+
+            if (entry.key == key) {
+                target = &entry;
+                break;
+            }
+            if (!this->is_live(entry, now)) {
+                target = &entry;
+            } else if (this->is_live(*target, now) &&
+                       entry.connection_time < target->connection_time) {
+                target = &entry;
+            }
+        }
+
+        if (target->key != key && this->is_live(*target, now)) {
+            this->evicted++;
+        }
+
+        *target = Entry{.key = key, .connection_time = now, .mtu = mtu};
+    }
+
+    std::optional<SemiConnectedClient>
+    HalfOpenTable::find(const detail::IPV4Addr& address, uint64_t now) const noexcept {
+        const auto key   = address.packed();
+        const auto first = this->set_of(key);
+
+        for (size_t way = 0; way < WAYS; way++) {
+            const auto& entry = this->entries[first + way];
+
+            if (entry.key == key && this->is_live(entry, now)) {
+                return SemiConnectedClient{
+                    .connection_time = entry.connection_time, .mtu = entry.mtu
+                };
+            }
+        }
+        return std::nullopt;
+    }
+
+    size_t HalfOpenTable::set_of(uint64_t key) const noexcept {
+        if (this->set_bits == 0) {
+            return 0;
+        }
+
+        const auto set = (key * 0x9E3779B97F4A7C15ull) >> (64 - this->set_bits);
+        return static_cast<size_t>(set) * WAYS;
+    }
+} // namespace rakro
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "rakro/internal/net.hpp"
+#include "rakro/server/server_client.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace rakro {
+
+    // How long an address that sent OCR1 is remembered for, and about how long a cookie holds
+    constexpr uint64_t HANDSHAKE_TIMEOUT_MS = 5000;
+
+    // Cookies for the OCR1 reply, so nothing has to be stored until OCR2 comes back with one.
+    // A cookie is a SipHash of the address and the current window of HANDSHAKE_TIMEOUT_MS
+    // under a key picked at startup, the previous window is still accepted so one issued
+    // right before the window turns over doesnt fail. Can't be forged without the key and
+    // only works from the address it was sent to
+    class HandshakeCookies {
+    public:
+        HandshakeCookies();
+
+        uint32_t issue(const detail::IPV4Addr& address, uint64_t now) const noexcept;
+        bool     check(const detail::IPV4Addr& address, uint32_t cookie, uint64_t now)
+            const noexcept;
+
+    private:
+        uint32_t make(uint64_t address, uint64_t window) const noexcept;
+
+    private:
+        std::array<uint64_t, 2> key{};
+    };
+
+    // Addresses that sent OCR1 but not OCR2 yet, for when cookies are off. Fixed size and set
+    // associative, an address can only go in one of 4 entries picked by its hash. Expired
+    // entries are just treated as free, and once all 4 are taken the oldest one makes room,
+    // so a flood of OCR1s only ever pushes out other half open handshakes
+    class HalfOpenTable {
+    public:
+        explicit HalfOpenTable(size_t capacity);
+
+        // Refreshes the entry if the address already has one
+        void insert(const detail::IPV4Addr& address, uint16_t mtu, uint64_t now) noexcept;
+
+        std::optional<SemiConnectedClient>
+        find(const detail::IPV4Addr& address, uint64_t now) const noexcept;
+
+        // Entries pushed out before they expired
+        size_t get_evicted() const noexcept { return this->evicted; }
+
+    private:
+        static constexpr size_t WAYS = 4;
+
+        struct Entry {
+            uint64_t key{0}; // Packed address, 0 is never a real client
+            uint64_t connection_time{0};
+            uint16_t mtu{0};
+        };
+
+        // First entry of the set the address belongs to
+        size_t set_of(uint64_t key) const noexcept;
+
+        bool is_live(const Entry& entry, uint64_t now) const noexcept {
+            return entry.key != 0 && now - entry.connection_time < HANDSHAKE_TIMEOUT_MS;
+        }
+
+    private:
+        std::vector<Entry> entries{};
+        size_t             set_bits{0};
+        size_t             evicted{0};
+    };
+} // namespace rakro
@@ -0,0 +1,185 @@
+#include "ingress.hpp"
+#include "rakro/internal/simd.hpp"
+#include "rakro/packet/frame_set.hpp"
+#include "rakro/packet/magic.hpp"
+#include "rakro/packet/packet_id.hpp"
+#include "rakro/packet/rak_address.hpp"
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+namespace rakro {
+
+    namespace {
+        struct OfflineLayout {
+            size_t magic_offset{};
+            size_t min_size{};
+        };
+
+        // Where the magic lives in each of the unconnected packets, and the smallest size
+        // they can be while still holding everything we read out of them
+        constexpr OfflineLayout offline_layout(uint8_t id) noexcept {
+            switch (static_cast<PacketId>(id)) {
+            case PacketId::UnconnectedPing1:
+            case PacketId::UnconnectedPing2: {
+                return {.magic_offset = 1 + 8, .min_size = 1 + 8 + sizeof(MagicType) + 8};
+            }
+            case PacketId::OpenConnectionRequest1: {
+                return {.magic_offset = 1, .min_size = 1 + sizeof(MagicType) + 1};
+            }
+            case PacketId::OpenConnectionRequest2: {
+                return {
+                    .magic_offset = 1,
+                    .min_size     = 1 + sizeof(MagicType) + packets::RakAddress::size() + 2 + 8
+                };
+            }
+            default: {
+                return {};
+            }
+            }
+        }
+
+        constexpr IngressBucket classify_leading_byte(uint8_t id) noexcept {
+            if (id >= packets::VALID_FRAME_MASK && id <= packets::VALID_MAX_FRAME_ID) {
+                return IngressBucket::FrameSet;
+            }
+
+            switch (static_cast<PacketId>(id)) {
+            case PacketId::Ack: return IngressBucket::Ack;
+            case PacketId::Nack: return IngressBucket::Nack;
+            case PacketId::UnconnectedPing1:
+            case PacketId::UnconnectedPing2:
+            case PacketId::OpenConnectionRequest1:
+            case PacketId::OpenConnectionRequest2: return IngressBucket::Unconnected;
+            default: return IngressBucket::Garbage;
+            }
+        }
+
+        bool valid_offline(std::span<const uint8_t> datagram) noexcept {
+            const auto layout = offline_layout(datagram[0]);
+
+            if (datagram.size() < layout.min_size) {
+                return false;
+            }
+
+            return detail::is_offline_magic(datagram.data() + layout.magic_offset);
+        }
+
+        // One bit per datagram in the batch for each bucket, garbage is whatever is left over
+        struct LaneMasks {
+            uint32_t unconnected{};
+            uint32_t frame_set{};
+            uint32_t ack{};
+            uint32_t nack{};
+        };
+
+        LaneMasks
+        classify_leading_bytes(const std::array<uint8_t, MAX_INGRESS_BATCH>& leading) noexcept {
+            LaneMasks masks{};
+
+#ifdef RAKRO_SSE2
+            const auto splat = [](auto value) {
+                return _mm_set1_epi8(static_cast<char>(value));
+            };
+
+            const auto frame_base  = splat(packets::VALID_FRAME_MASK);
+            const auto frame_range =
+                splat(packets::VALID_MAX_FRAME_ID - packets::VALID_FRAME_MASK);
+            const auto ack_id      = splat(PacketId::Ack);
+            const auto nack_id     = splat(PacketId::Nack);
+            const auto ping1       = splat(PacketId::UnconnectedPing1);
+            const auto ping2       = splat(PacketId::UnconnectedPing2);
+            const auto ocr1        = splat(PacketId::OpenConnectionRequest1);
+            const auto ocr2        = splat(PacketId::OpenConnectionRequest2);
+
+            for (size_t lane = 0; lane < MAX_INGRESS_BATCH; lane += 16) {
+                const auto bytes = detail::load_128(leading.data() + lane);
+
+                // Unsigned range check, (id - 0x80) <= 0xD, done as min(x, 0xD) == x
+                const auto frame_offset = _mm_sub_epi8(bytes, frame_base);
+                const auto is_frame =
+                    _mm_cmpeq_epi8(_mm_min_epu8(frame_offset, frame_range), frame_offset);
+
+                const auto is_unconnected = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(bytes, ping1), _mm_cmpeq_epi8(bytes, ping2)),
+                    _mm_or_si128(_mm_cmpeq_epi8(bytes, ocr1), _mm_cmpeq_epi8(bytes, ocr2))
+                );
+
+                masks.frame_set |= detail::byte_mask(is_frame) << lane;
+                masks.unconnected |= detail::byte_mask(is_unconnected) << lane;
+                masks.ack |= detail::byte_mask(_mm_cmpeq_epi8(bytes, ack_id)) << lane;
+                masks.nack |= detail::byte_mask(_mm_cmpeq_epi8(bytes, nack_id)) << lane;
+            }
+#else
+            for (size_t lane = 0; lane < MAX_INGRESS_BATCH; lane++) {
+                const auto bit = uint32_t{1} << lane;
+                switch (classify_leading_byte(leading[lane])) {
+                case IngressBucket::Unconnected: masks.unconnected |= bit; break;
+                case IngressBucket::FrameSet: masks.frame_set |= bit; break;
+                case IngressBucket::Ack: masks.ack |= bit; break;
+                case IngressBucket::Nack: masks.nack |= bit; break;
+                case IngressBucket::Garbage: break;
+                }
+            }
+#endif
+
+            return masks;
+        }
+    } // namespace
+
+    IngressBucket classify_datagram(std::span<const uint8_t> datagram) noexcept {
+        if (datagram.empty()) {
+            return IngressBucket::Garbage;
+        }
+
+        const auto bucket = classify_leading_byte(datagram[0]);
+
+        if (bucket == IngressBucket::Unconnected && !valid_offline(datagram)) {
+            return IngressBucket::Garbage;
+        }
+
+        return bucket;
+    }
+
+    void classify_ingress(
+        std::span<const std::span<const uint8_t>> datagrams, IngressClassification& out
+    ) noexcept {
+        out.clear();
+
+        const auto count = std::min(datagrams.size(), MAX_INGRESS_BATCH);
+
+        // Empty datagrams get a leading byte of 0 (ConnectedPingPong), which is never valid
+        // outside of a frame set, so they land in garbage without a branch
+        std::array<uint8_t, MAX_INGRESS_BATCH> leading{};
+        for (size_t x = 0; x < count; x++) {
+            leading[x] = datagrams[x].empty() ? uint8_t{0} : datagrams[x][0];
+        }
+
+        const auto live_lanes =
+            (count == MAX_INGRESS_BATCH) ? ~uint32_t{0} : ((uint32_t{1} << count) - 1);
+
+        auto masks = classify_leading_bytes(leading);
+        masks.unconnected &= live_lanes;
+        masks.frame_set &= live_lanes;
+        masks.ack &= live_lanes;
+        masks.nack &= live_lanes;
+
+        // Unconnected packets are the only ones with a fixed magic, so they are the only ones
+        // which can be proven garbage this early
+        for (auto pending = masks.unconnected; pending != 0; pending &= pending - 1) {
+            const auto lane = static_cast<size_t>(std::countr_zero(pending));
+            if (!valid_offline(datagrams[lane])) {
+                masks.unconnected &= ~(uint32_t{1} << lane);
+            }
+        }
+
+        const auto garbage =
+            live_lanes & ~(masks.unconnected | masks.frame_set | masks.ack | masks.nack);
+
+        out.push_lanes(IngressBucket::Unconnected, masks.unconnected);
+        out.push_lanes(IngressBucket::FrameSet, masks.frame_set);
+        out.push_lanes(IngressBucket::Ack, masks.ack);
+        out.push_lanes(IngressBucket::Nack, masks.nack);
+        out.push_lanes(IngressBucket::Garbage, garbage);
+    }
+} // namespace rakro
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace rakro {
+
+    // Which path a raw datagram should take once it has left the socket
+    enum class IngressBucket : uint8_t { Unconnected, FrameSet, Ack, Nack, Garbage };
+
+    constexpr size_t INGRESS_BUCKET_COUNT = 5;
+    constexpr size_t MAX_INGRESS_BATCH    = 32; // Has to fit in the 32 bit lane masks
+
+    // Output of a classification pass. Every bucket holds the indexes into the batch of the
+    // datagrams that belong to it, in the order they were received
+    class IngressClassification {
+    public:
+        std::span<const uint8_t> bucket(IngressBucket bucket) const noexcept {
+            const auto index = static_cast<size_t>(bucket);
+            return std::span(this->indexes[index]).subspan(0, this->counts[index]);
+        }
+
+        void push(IngressBucket bucket, uint8_t batch_index) noexcept {
+            const auto index = static_cast<size_t>(bucket);
+            this->indexes[index][this->counts[index]++] = batch_index;
+        }
+
+        // Appends every set lane of a 32 bit lane mask, lowest lane first
+        void push_lanes(IngressBucket bucket, uint32_t lanes) noexcept {
+            const auto index = static_cast<size_t>(bucket);
+            auto&      out   = this->indexes[index];
+            auto       count = static_cast<size_t>(this->counts[index]);
+
+            for (; lanes != 0; lanes &= lanes - 1) {
+                out[count++] = static_cast<uint8_t>(std::countr_zero(lanes));
+            }
+
+            this->counts[index] = static_cast<uint8_t>(count);
+        }
+
+        void clear() noexcept { this->counts = {}; }
+
+    private:
+        std::array<std::array<uint8_t, MAX_INGRESS_BATCH>, INGRESS_BUCKET_COUNT> indexes{};
+        std::array<uint8_t, INGRESS_BUCKET_COUNT>                               counts{};
+    };
+
+    // Sorts a batch of received datagrams into their buckets in one pass. The leading bytes
+    // of the whole batch are classified together with vector compares, and unconnected
+    // packets additionally have their offline magic checked, anything that fails is garbage.
+    // Only the first MAX_INGRESS_BATCH datagrams are looked at
+    void classify_ingress(
+        std::span<const std::span<const uint8_t>> datagrams, IngressClassification& out
+    ) noexcept;
+
+    // Single datagram version of the above, used as the scalar reference
+    IngressBucket classify_datagram(std::span<const uint8_t> datagram) noexcept;
+
+} // namespace rakro
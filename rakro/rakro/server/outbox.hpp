@@ -0,0 +1,132 @@
+#pragma once
+
+#include "rakro/internal/mpsc_queue.hpp"
+#include "rakro/packet/frame_set.hpp"
+#include "rakro/server/events.hpp"
+#include "rakro/server/payload_pipeline.hpp"
+#include "rakro/server/send_priority.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace rakro {
+
+    // Sends one router can have waiting before game threads are turned away
+    constexpr size_t SEND_QUEUE_CAPACITY = size_t{1} << 16;
+    // Sends a router takes off its outbox per tick, the rest wait for the next one
+    constexpr size_t MAX_SENDS_PER_TICK = size_t{1} << 15;
+    // Queued payloads keep their buffer for the next lap, unless it grew past this
+    constexpr size_t SEND_SLOT_KEEP_BYTES = 2048;
+
+    struct OutgoingMessage {
+        ClientHandle              client{};
+        std::span<const uint8_t>  payload{}; // Copied while queueing, can go right after
+        packets::FrameReliability rely{packets::FrameReliability::ReliableOrdered};
+        uint8_t                   channel{0}; // Ordering channel, below MAX_ORDER_CHANNELS
+        SendPriority              priority{SendPriority::Medium};
+        uint32_t                  receipt{0}; // WithAckReceipt reliabilities only
+    };
+
+    // One body for many clients, serialised once by whoever queues it
+    struct Broadcast {
+        SharedBody                body{};
+        packets::FrameReliability rely{packets::FrameReliability::ReliableOrdered};
+        uint8_t                   channel{0};
+        SendPriority              priority{SendPriority::Medium};
+    };
+
+    // One slot of the outbox, the router side copy of an OutgoingMessage. With shared set it
+    // is a broadcast instead, to recipients, or to everyone but them with everyone set. With
+    // settings set it only swaps client's PayloadSettings, in line with its sends
+    struct QueuedSend {
+        ClientHandle                   client{};
+        std::vector<uint8_t>           payload{};
+        packets::FrameReliability      rely{};
+        uint8_t                        channel{0};
+        SendPriority                   priority{};
+        uint32_t                       receipt{0};
+        SharedBody                     shared{};
+        std::vector<ClientHandle>      recipients{};
+        bool                           everyone{false};
+        std::optional<PayloadSettings> settings{};
+    };
+
+    // Where game threads leave messages for the clients of one router. Any number of threads
+    // can push at once without locking, the router drains it once per tick
+    class Outbox {
+    public:
+        explicit Outbox(size_t capacity = SEND_QUEUE_CAPACITY) : queue(capacity) {}
+        Outbox(const Outbox&) = delete;
+
+        // Any thread. Queues as many of messages as fit, in order, with one CAS between them.
+        // Returns how many that was
+        size_t push(std::span<const OutgoingMessage> messages) {
+            return this->push(messages.size(), [&](size_t index) -> const OutgoingMessage& {
+                return messages[index];
+            });
+        }
+
+        // Same, for count messages picked by get(index)
+        template <typename Get> size_t push(size_t count, Get&& get) {
+            return this->queue.try_push_bulk(count, [&](QueuedSend& slot, size_t index) {
+                const OutgoingMessage& message = get(index);
+
+                slot.client   = message.client;
+                slot.rely     = message.rely;
+                slot.channel  = message.channel;
+                slot.priority = message.priority;
+                slot.receipt  = message.receipt;
+                slot.payload.assign(message.payload.begin(), message.payload.end());
+            });
+        }
+
+        // Any thread. Takes one slot for the whole broadcast, the count clients picked by
+        // get(index) are its recipients, or the ones left out with everyone set
+        template <typename Get>
+        bool
+        push_broadcast(const Broadcast& broadcast, bool everyone, size_t count, Get&& get) {
+            return this->queue.try_push([&](QueuedSend& slot) {
+                slot.rely     = broadcast.rely;
+                slot.channel  = broadcast.channel;
+                slot.priority = broadcast.priority;
+                slot.shared   = broadcast.body;
+                slot.everyone = everyone;
+
+                slot.recipients.clear();
+                for (size_t index = 0; index < count; index++) {
+                    slot.recipients.push_back(get(index));
+                }
+            });
+        }
+
+        // Any thread. Sends queued for client before this go out with its old settings, the
+        // ones after with settings
+        bool push_settings(const ClientHandle& client, const PayloadSettings& settings) {
+            return this->queue.try_push([&](QueuedSend& slot) {
+                slot.client   = client;
+                slot.settings = settings;
+            });
+        }
+
+        // Router thread only
+        template <typename Handle> size_t drain(size_t max, Handle&& handle) {
+            return this->queue.consume(max, [&](QueuedSend& slot) {
+                handle(static_cast<const QueuedSend&>(slot));
+
+                if (slot.payload.capacity() > SEND_SLOT_KEEP_BYTES) {
+                    slot.payload = {};
+                } else {
+                    slot.payload.clear();
+                }
+                // Every queued frame holds its own reference by now
+                slot.shared.reset();
+                slot.settings.reset();
+            });
+        }
+
+    private:
+        MpscQueue<QueuedSend> queue;
+    };
+} // namespace rakro
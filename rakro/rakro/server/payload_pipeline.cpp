@@ -0,0 +1,143 @@
+#include "payload_pipeline.hpp"
+#include "rakro/packet/packet_id.hpp"
+#include <cstring>
+#include <utility>
+
+namespace rakro {
+
+    namespace {
+        size_t framed_size(std::span<const std::span<const uint8_t>> game_packets) noexcept {
+            size_t size = 0;
+            for (const auto packet : game_packets) {
+                size += packets::detail::varuint32_size(static_cast<uint32_t>(packet.size())) +
+                        packet.size();
+            }
+            return size;
+        }
+
+        // out has to have framed_size(game_packets) bytes of room
+        void frame_packets(
+            std::span<const std::span<const uint8_t>> game_packets, uint8_t* out
+        ) noexcept {
+            for (const auto packet : game_packets) {
+                const auto length = static_cast<uint32_t>(packet.size());
+                out += packets::detail::write_varuint32(length, out);
+                if (!packet.empty()) {
+                    std::memcpy(out, packet.data(), packet.size());
+                    out += packet.size();
+                }
+            }
+        }
+
+        std::optional<DecodedBatch> split(std::span<uint8_t> payload, RentedCodec codec) {
+            const auto view = packets::BatchView::from_bytes(payload);
+
+            if (!view.has_value()) {
+                return std::nullopt;
+            }
+
+            return DecodedBatch(view.value(), std::move(codec));
+        }
+    } // namespace
+
+    std::optional<DecodedBatch> PayloadPipeline::decode(std::span<uint8_t> batch) {
+        if (!this->settings.compressed) {
+            return split(batch, RentedCodec());
+        }
+
+        if (batch.empty()) {
+            return std::nullopt;
+        }
+
+        const auto payload = batch.subspan(1);
+
+        switch (static_cast<packets::BatchCompression>(batch[0])) {
+        case packets::BatchCompression::None: {
+            return split(payload, RentedCodec());
+        }
+        case packets::BatchCompression::Deflate: {
+            auto       codec    = this->pool->rent();
+            const auto inflated = codec->inflate(payload, this->settings.max_batch_size);
+
+            if (!inflated.has_value()) {
+                return std::nullopt;
+            }
+
+            return split(inflated.value(), std::move(codec));
+        }
+        default: {
+            return std::nullopt; // Snappy, which we never negotiate
+        }
+        }
+    }
+
+    bool PayloadPipeline::encode(
+        std::span<const std::span<const uint8_t>> game_packets, BinaryBuffer& out
+    ) {
+        const auto payload_size = framed_size(game_packets);
+        const auto header_size  = this->settings.compressed ? size_t{2} : size_t{1};
+
+        const bool should_compress = this->settings.compressed &&
+                                     payload_size >= this->settings.threshold &&
+                                     CodecContext::has_deflate();
+
+        if (out.remaining() < header_size) {
+            return false;
+        }
+
+        out.write(std::to_underlying(PacketId::GameBatch));
+
+        if (!should_compress) {
+            if (this->settings.compressed) {
+                out.write(std::to_underlying(packets::BatchCompression::None));
+            }
+
+            if (out.remaining() < payload_size) {
+                return false;
+            }
+
+            frame_packets(game_packets, out.remaining_slice().data());
+            out.skipn(payload_size);
+            return true;
+        }
+
+        // Frame into the codec scratch first, deflate then writes straight into out
+        auto  codec   = this->pool->rent();
+        auto& scratch = codec->get_scratch();
+
+        if (scratch.size() < payload_size) {
+            scratch.resize(payload_size);
+        }
+
+        frame_packets(game_packets, scratch.data());
+
+        const auto framed  = std::span(scratch).subspan(0, payload_size);
+        const auto written = codec->deflate(
+            framed, out.remaining_slice().subspan(1), this->settings.level
+        );
+
+        if (written.has_value()) {
+            out.write(std::to_underlying(packets::BatchCompression::Deflate));
+            out.skipn(written.value());
+            return true;
+        }
+
+        // Didnt shrink, already random looking data does that
+        out.write(std::to_underlying(packets::BatchCompression::None));
+
+        if (out.remaining() < payload_size) {
+            return false;
+        }
+
+        std::memcpy(out.remaining_slice().data(), framed.data(), payload_size);
+        out.skipn(payload_size);
+        return true;
+    }
+
+    size_t PayloadPipeline::max_encoded_size(
+        std::span<const std::span<const uint8_t>> game_packets
+    ) const noexcept {
+        // Id and algorithm byte, deflate falls back to the packets as they are
+        return 2 + framed_size(game_packets);
+    }
+} // namespace rakro
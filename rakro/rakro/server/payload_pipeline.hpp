@@ -0,0 +1,74 @@
+#pragma once
+
+#include "rakro/internal/binary_buffer.hpp"
+#include "rakro/internal/codec_pool.hpp"
+#include "rakro/packet/game_batch.hpp"
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace rakro {
+
+    struct PayloadSettings {
+        // Off hands game batches over untouched, the way they always were
+        bool enabled{false};
+        // Set once the game has negotiated compression, from then on every batch carries an
+        // algorithm byte in front of the payload
+        bool compressed{false};
+        // Outgoing batches smaller than this go out uncompressed
+        uint16_t threshold{256};
+        // zlib level, -1 for the default
+        int level{7};
+        // Anything inflating past this is dropped instead of eating all our memory
+        uint32_t max_batch_size{uint32_t{1} << 23};
+
+        bool operator==(const PayloadSettings&) const = default;
+    };
+
+    // A batch split into its packets. If it had to be inflated it holds on to the codec
+    // context the packets live in, so keep it alive for as long as the packets are needed
+    class DecodedBatch {
+    public:
+        DecodedBatch(packets::BatchView view, RentedCodec codec)
+            : view(view), codec(std::move(codec)) {}
+
+        const packets::BatchView& packets() const noexcept { return this->view; }
+
+    private:
+        packets::BatchView view{};
+        RentedCodec        codec{};
+    };
+
+    // Per connection stage between the reliability layer and the game. Inbound batches are
+    // inflated (if needed) and split into packets without copying them, outbound ones are
+    // framed and deflated once they pass the threshold
+    class PayloadPipeline {
+    public:
+        PayloadPipeline() = default;
+        PayloadPipeline(CodecPool* pool, PayloadSettings settings)
+            : pool(pool), settings(settings) {}
+
+        bool is_enabled() const noexcept { return this->settings.enabled; }
+
+        const PayloadSettings& get_settings() const noexcept { return this->settings; }
+        void update_settings(PayloadSettings new_settings) noexcept {
+            this->settings = new_settings;
+        }
+
+        // batch is everything after the 0xFE id
+        std::optional<DecodedBatch> decode(std::span<uint8_t> batch);
+
+        // Writes a full game batch (0xFE included), false if it doesnt fit into out. Nothing
+        // sensible is left in out when that happens. A batch deflate would only grow goes out
+        // uncompressed
+        bool encode(std::span<const std::span<const uint8_t>> game_packets, BinaryBuffer& out);
+
+        // Room encode needs at most for game_packets, compressed or not
+        size_t
+        max_encoded_size(std::span<const std::span<const uint8_t>> game_packets) const noexcept;
+
+    private:
+        CodecPool*      pool{nullptr};
+        PayloadSettings settings{};
+    };
+} // namespace rakro
@@ -0,0 +1,86 @@
+#include "rate_limit.hpp"
+#include <algorithm>
+#include <bit>
+#include <random>
+
+namespace rakro {
+
+    SourceRateLimiter::SourceRateLimiter(RateLimitSettings settings)
+        : per_address(settings.per_address, settings.buckets),
+          per_subnet(settings.per_subnet, settings.buckets) {
+        const auto bits   = std::min<uint32_t>(settings.subnet_bits, 32);
+        this->subnet_mask = bits == 0 ? 0 : ~uint32_t{0} << (32 - bits);
+    }
+
+    bool SourceRateLimiter::allow(const detail::IPV4Addr& address, uint64_t now) noexcept {
+        const auto ip = ntohl(address.address.sin_addr.s_addr);
+
+        // Checked first so one noisy address doesnt also eat its neighbours' budget
+        if (!this->per_address.take(ip, now)) {
+            bump(this->dropped_address);
+            return false;
+        }
+
+        if (!this->per_subnet.take(ip & this->subnet_mask, now)) {
+            bump(this->dropped_subnet);
+            return false;
+        }
+
+        bump(this->allowed);
+        return true;
+    }
+
+    RateLimitStats SourceRateLimiter::get_stats() const noexcept {
+        return RateLimitStats{
+            .allowed         = this->allowed.load(std::memory_order_relaxed),
+            .dropped_address = this->dropped_address.load(std::memory_order_relaxed),
+            .dropped_subnet  = this->dropped_subnet.load(std::memory_order_relaxed),
+        };
+    }
+
+    SourceRateLimiter::Table::Table(RateLimit limit, size_t buckets) : limit(limit) {
+        if (!this->is_enabled()) {
+            return;
+        }
+
+        const auto count = std::bit_ceil(std::max(buckets, size_t{2}));
+        this->buckets.resize(count);
+        this->shift = 64 - static_cast<size_t>(std::countr_zero(count));
+
+        // Multiply-shift with a random odd multiplier, any two addresses collide with a
+        // chance of about 2 / count, and which ones do changes every run
+        auto device      = std::random_device();
+        this->multiplier = (uint64_t{device()} << 32 | device()) | 1;
+    }
+
+    bool SourceRateLimiter::Table::take(uint32_t key, uint64_t now) noexcept {
+        if (!this->is_enabled()) {
+            return true;
+        }
+
+        const auto index  = (uint64_t{key} * this->multiplier) >> this->shift;
+        auto&      bucket = this->buckets[static_cast<size_t>(index)];
+
+        const auto capacity = uint64_t{this->limit.burst} * 1000;
+
+        // Sources that share a bucket also share its tokens. Handing a newcomer a full one
+        // instead would let two colliding addresses refill each other forever, this way one
+        // only gets a full bucket once everyone on it went quiet long enough to refill it
+        if (bucket.updated == 0) {
+            bucket = Bucket{.tokens = static_cast<uint32_t>(capacity), .updated = now};
+        } else if (now > bucket.updated) {
+            // rate tokens a second is rate thousandths a millisecond
+            const auto refill = (now - bucket.updated) * this->limit.rate;
+
+            bucket.tokens  = static_cast<uint32_t>(std::min(bucket.tokens + refill, capacity));
+            bucket.updated = now;
+        }
+
+        if (bucket.tokens < 1000) {
+            return false;
+        }
+
+        bucket.tokens -= 1000;
+        return true;
+    }
+} // namespace rakro
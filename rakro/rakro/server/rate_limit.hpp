@@ -0,0 +1,87 @@
+#pragma once
+
+#include "rakro/internal/net.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rakro {
+
+    // Token bucket, refills rate tokens a second up to burst. A rate of 0 turns it off
+    struct RateLimit {
+        uint32_t rate{0};
+        uint32_t burst{0};
+    };
+
+    struct RateLimitSettings {
+        // Unconnected pings and handshake packets from one IP
+        RateLimit per_address{.rate = 10, .burst = 20};
+        // The same from everyone in one subnet, so spreading a flood over a /24 doesnt help
+        RateLimit per_subnet{.rate = 200, .burst = 400};
+        uint8_t   subnet_bits{24};
+        // Buckets per table, rounded up to a power of two. Two sources that land on the same
+        // bucket share its tokens, neither gets a fresh one while the other keeps it busy
+        size_t buckets{4096};
+    };
+
+    struct RateLimitStats {
+        uint64_t allowed{0};
+        uint64_t dropped_address{0};
+        uint64_t dropped_subnet{0};
+    };
+
+    // Decides whether an unconnected datagram gets handled at all, before anything is parsed
+    // or written. Both tables are plain arrays of 16 byte buckets indexed by a hash of the
+    // address, there is no probing and nothing is ever allocated after construction. The
+    // hash is seeded per process, so which addresses collide cant be worked out ahead.
+    //
+    // allow runs on the listener thread only, get_stats is fine from any thread
+    class SourceRateLimiter {
+    public:
+        explicit SourceRateLimiter(RateLimitSettings settings);
+        SourceRateLimiter(const SourceRateLimiter&) = delete;
+
+        bool allow(const detail::IPV4Addr& address, uint64_t now) noexcept;
+
+        RateLimitStats get_stats() const noexcept;
+
+    private:
+        // Not tied to one address, whoever hashes to it draws from it
+        struct Bucket {
+            uint32_t tokens{0};  // In thousandths of a token
+            uint64_t updated{0}; // 0 means never used
+        };
+
+        class Table {
+        public:
+            Table(RateLimit limit, size_t buckets);
+
+            // Takes a token from key's bucket, false if there wasnt one
+            bool take(uint32_t key, uint64_t now) noexcept;
+
+            bool is_enabled() const noexcept { return this->limit.rate != 0; }
+
+        private:
+            RateLimit           limit{};
+            std::vector<Bucket> buckets{};
+            size_t              shift{0};
+            uint64_t            multiplier{0}; // Random and odd, see the constructor
+        };
+
+        // Only the listener thread writes, so these dont need an atomic add
+        static void bump(std::atomic<uint64_t>& counter) noexcept {
+            const auto value = counter.load(std::memory_order_relaxed);
+            counter.store(value + 1, std::memory_order_relaxed);
+        }
+
+    private:
+        Table    per_address;
+        Table    per_subnet;
+        uint32_t subnet_mask{0};
+
+        std::atomic<uint64_t> allowed{0};
+        std::atomic<uint64_t> dropped_address{0};
+        std::atomic<uint64_t> dropped_subnet{0};
+    };
+} // namespace rakro
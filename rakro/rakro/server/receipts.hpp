@@ -0,0 +1,88 @@
+#pragma once
+
+#include "rakro/internal/int24_t.hpp"
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace rakro {
+
+    enum class ReceiptStatus : uint8_t {
+        Acked,
+        // Unreliable frames get lost, reliable ones are resent until acked unless the client
+        // disconnects first
+        Lost,
+    };
+
+    struct ReceiptEvent {
+        uint32_t      receipt{};
+        ReceiptStatus status{};
+    };
+
+    // What a datagram carries that somebody is waiting on a receipt for
+    struct DatagramReceipts {
+        std::vector<uint32_t> unreliable{}; // Lost along with the datagram
+        bool                  reliable{false};
+
+        bool empty() const noexcept { return this->unreliable.empty() && !this->reliable; }
+    };
+
+    // Per connection bookkeeping for frames sent with an ack receipt. Reliable frames are
+    // matched up on their reliable index, a split packet is only acked once every fragment
+    // is. Unreliable ones ride along with their datagram instead, see DatagramReceipts.
+    //
+    // Events pile up until the tick hands them over in one batch
+    class ReceiptTracker {
+    public:
+        // Every fragment has to be tracked before the first one can go out
+        void track_reliable(uint24_t reliable_index, uint32_t receipt) {
+            this->by_reliable_index.insert({reliable_index.get_value(), receipt});
+            this->outstanding[receipt]++;
+        }
+
+        bool has_reliable() const noexcept { return !this->by_reliable_index.empty(); }
+
+        bool is_tracked(uint24_t reliable_index) const noexcept {
+            return this->by_reliable_index.contains(reliable_index.get_value());
+        }
+
+        // Resends of the same index after the first ack are ignored
+        void on_reliable_acked(uint24_t reliable_index) {
+            const auto entry = this->by_reliable_index.find(reliable_index.get_value());
+            if (entry == this->by_reliable_index.end()) {
+                return;
+            }
+
+            const auto receipt = entry->second;
+            this->by_reliable_index.erase(entry);
+
+            const auto remaining = this->outstanding.find(receipt);
+            if (--remaining->second == 0) {
+                this->outstanding.erase(remaining);
+                this->ready.push_back({.receipt = receipt, .status = ReceiptStatus::Acked});
+            }
+        }
+
+        void on_unreliable(uint32_t receipt, ReceiptStatus status) {
+            this->ready.push_back({.receipt = receipt, .status = status});
+        }
+
+        // The connection is going away, every reliable receipt still waiting is lost
+        void lose_reliable() {
+            for (const auto& [receipt, remaining] : this->outstanding) {
+                this->ready.push_back({.receipt = receipt, .status = ReceiptStatus::Lost});
+            }
+            this->outstanding.clear();
+            this->by_reliable_index.clear();
+        }
+
+        std::span<const ReceiptEvent> get_events() const noexcept { return this->ready; }
+        void                          clear_events() noexcept { this->ready.clear(); }
+
+    private:
+        std::unordered_map<uint32_t, uint32_t> by_reliable_index{}; // To its receipt
+        std::unordered_map<uint32_t, uint32_t> outstanding{};       // Frames left per receipt
+        std::vector<ReceiptEvent>              ready{};
+    };
+} // namespace rakro
@@ -0,0 +1,192 @@
+#pragma once
+
+#include "rakro/internal/binary_buffer.hpp"
+#include "rakro/internal/int24_t.hpp"
+#include "rakro/internal/scratch_pool.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <utility>
+
+namespace rakro {
+
+    constexpr size_t MAX_ORDER_CHANNELS = 32;
+
+    // How far ahead of the next expected index a frame may be and still get held on to, a
+    // power of two so the slot is just the low bits of the index
+    constexpr uint32_t REORDER_WINDOW = 256;
+    // Frames held across every channel of a connection
+    constexpr size_t MAX_HELD_FRAMES = 512;
+    // Scratch memory held across every channel of a connection, enough for a full
+    // MAX_HELD_FRAMES of small frames in their smallest scratch blocks
+    constexpr size_t MAX_HELD_BYTES = size_t{1} << 21;
+
+    static_assert((REORDER_WINDOW & (REORDER_WINDOW - 1)) == 0);
+
+    enum class OrderOutcome : uint8_t {
+        Delivered, // Along with whatever it unblocked
+        Held,      // Something before it is still missing
+        Stale,     // Delivered already
+        TooFarAhead,
+        Full,
+    };
+
+    // Per connection ordering for every channel. In order frames are handed over as is, the
+    // ring for a channel only gets allocated the first time something arrives early on it.
+    //
+    // Early frames are copied out of their datagram into scratch memory, the datagram is
+    // long gone by the time they are delivered. Reassembled split packets already have memory
+    // of their own, that is taken over instead. Nothing here comes out of the BufferCompany,
+    // a client holding frames back cant starve the listener of datagram buffers
+    class OrderingChannels {
+    public:
+        OrderingChannels() = default;
+        explicit OrderingChannels(ScratchPool* scratch) : scratch(scratch) {}
+
+        uint24_t get_next(uint8_t channel) const noexcept { return this->next_index[channel]; }
+
+        // deliver is called with a BinaryBuffer for the frame if it is next in line, and then
+        // for every held frame it unblocks, in order. channel has to be checked against
+        // MAX_ORDER_CHANNELS by the caller
+        template <typename Deliver>
+        OrderOutcome
+        receive(uint8_t channel, uint24_t index, std::span<uint8_t> data, Deliver&& deliver) {
+            return this->receive(channel, index, data, nullptr, std::forward<Deliver>(deliver));
+        }
+
+        // Same, but data starts owned, which is moved into the ring if the frame has to be
+        // held. Left alone otherwise
+        template <typename Deliver>
+        OrderOutcome receive(
+            uint8_t channel, uint24_t index, std::span<uint8_t> data, RentedScratch* owned,
+            Deliver&& deliver
+        ) {
+            const auto is_owned = owned != nullptr && *owned;
+            const auto outcome  = this->check(
+                channel, index, is_owned ? 0 : std::max(data.size(), size_t{1})
+            );
+
+            if (outcome == OrderOutcome::Held) {
+                this->hold(channel, index, data, is_owned ? owned : nullptr);
+            }
+            if (outcome != OrderOutcome::Delivered) {
+                return outcome;
+            }
+
+            auto& next = this->next_index[channel];
+
+            deliver(BinaryBuffer(RentedBuffer(data, nullptr)));
+            ++next;
+
+            auto& ring = this->rings[channel];
+            if (!ring) {
+                return OrderOutcome::Delivered;
+            }
+
+            // Everything waiting on this one sits in the slots right after it
+            while (ring->held != 0) {
+                auto& slot = ring->slots[next.get_value() & (REORDER_WINDOW - 1)];
+                if (!slot.held) {
+                    break;
+                }
+
+                deliver(BinaryBuffer(RentedBuffer(slot.data(), nullptr)));
+                this->held_bytes -= slot.memory.get_memory().size();
+                slot.release();
+                ring->held--;
+                this->total_held--;
+                ++next;
+            }
+
+            return OrderOutcome::Delivered;
+        }
+
+        // What receive would do with a frame of size bytes, without doing it. A size of 0 is
+        // a reassembled packet, those are never Full, their memory is spent either way and
+        // their fragments were checked on the way in
+        OrderOutcome check(uint8_t channel, uint24_t index, size_t size) const noexcept {
+            const auto ahead = sequence_delta(index, this->next_index[channel]);
+
+            if (ahead < 0) {
+                return OrderOutcome::Stale;
+            }
+            if (ahead == 0) {
+                return OrderOutcome::Delivered;
+            }
+            if (ahead >= static_cast<int32_t>(REORDER_WINDOW)) {
+                return OrderOutcome::TooFarAhead;
+            }
+
+            const auto& ring = this->rings[channel];
+            if (ring && ring->slots[index.get_value() & (REORDER_WINDOW - 1)].held) {
+                return OrderOutcome::Stale; // A resend of one we are already holding
+            }
+
+            if (size != 0 && (this->total_held >= MAX_HELD_FRAMES ||
+                              this->held_bytes + size > MAX_HELD_BYTES)) {
+                return OrderOutcome::Full;
+            }
+            return OrderOutcome::Held;
+        }
+
+        size_t get_held() const noexcept { return this->total_held; }
+        size_t get_held_bytes() const noexcept { return this->held_bytes; }
+
+    private:
+        struct HeldFrame {
+            RentedScratch memory{};
+            size_t        size{0};
+            bool          held{false};
+
+            std::span<uint8_t> data() noexcept {
+                return this->memory.get_memory().subspan(0, this->size);
+            }
+
+            void release() noexcept {
+                this->memory = RentedScratch();
+                this->size   = 0;
+                this->held   = false;
+            }
+        };
+
+        struct Ring {
+            std::array<HeldFrame, REORDER_WINDOW> slots{};
+            size_t                                held{0};
+        };
+
+        // Only once check said Held
+        void hold(
+            uint8_t channel, uint24_t index, std::span<uint8_t> data, RentedScratch* owned
+        ) {
+            auto& ring = this->rings[channel];
+            if (!ring) {
+                ring = std::make_unique<Ring>();
+            }
+
+            auto& slot = ring->slots[index.get_value() & (REORDER_WINDOW - 1)];
+            slot.size  = data.size();
+            slot.held  = true;
+
+            if (owned != nullptr) {
+                slot.memory = std::move(*owned);
+            } else {
+                slot.memory = this->scratch->rent(data.size());
+                std::memcpy(slot.data().data(), data.data(), data.size());
+            }
+
+            ring->held++;
+            this->total_held++;
+            this->held_bytes += slot.memory.get_memory().size();
+        }
+
+    private:
+        ScratchPool*                                          scratch{nullptr};
+        std::array<uint24_t, MAX_ORDER_CHANNELS>              next_index{};
+        std::array<std::unique_ptr<Ring>, MAX_ORDER_CHANNELS> rings{};
+        size_t                                                total_held{0};
+        size_t                                                held_bytes{0};
+    };
+} // namespace rakro
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "rakro/internal/binary_buffer.hpp"
+#include "rakro/internal/int24_t.hpp"
+#include "rakro/server/receipts.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace rakro {
+
+    // All in milliseconds, same clock as detail::time_since_epoch
+    constexpr uint64_t INITIAL_RTO = 1000;
+    constexpr uint64_t MIN_RTO     = 50;
+    constexpr uint64_t MAX_RTO     = 10000;
+
+    // RFC 6298 style smoothed RTT. Every retransmission goes out under a fresh sequence
+    // number, so an ack always belongs to exactly one send and every sample is usable
+    class RttEstimator {
+    public:
+        void on_sample(uint64_t rtt) noexcept {
+            if (!this->has_sample) {
+                this->srtt       = rtt;
+                this->rttvar     = rtt / 2;
+                this->has_sample = true;
+            } else {
+                const auto error = this->srtt > rtt ? this->srtt - rtt : rtt - this->srtt;
+                this->rttvar     = (3 * this->rttvar + error) / 4;
+                this->srtt       = (7 * this->srtt + rtt) / 8;
+            }
+
+            const auto variance = std::max(uint64_t{1}, 4 * this->rttvar);
+            this->rto           = std::clamp(this->srtt + variance, MIN_RTO, MAX_RTO);
+        }
+
+        // Exponential backoff, undone by the next sample
+        void on_timeout() noexcept { this->rto = std::min(this->rto * 2, MAX_RTO); }
+
+        bool     has_samples() const noexcept { return this->has_sample; }
+        uint64_t get_rto() const noexcept { return this->rto; }
+        uint64_t get_srtt() const noexcept { return this->srtt; }
+        uint64_t get_rttvar() const noexcept { return this->rttvar; }
+
+    private:
+        uint64_t srtt{0};
+        uint64_t rttvar{0};
+        uint64_t rto{INITIAL_RTO};
+        bool     has_sample{false};
+    };
+
+    // A datagram holding reliable frames, or frames with a receipt, that hasnt been acked yet
+    struct SentDatagram {
+        BinaryBuffer     datagram{};
+        uint64_t         sent_at{};
+        uint64_t         deadline{};
+        DatagramReceipts receipts{};
+    };
+
+    struct RetransmitTimer {
+        uint64_t deadline{};
+        uint24_t sequence{};
+
+        bool operator>(const RetransmitTimer& other) const noexcept {
+            return this->deadline > other.deadline;
+        }
+    };
+
+    // Earliest deadline on top. Acked datagrams are not removed, their timers are skipped
+    // once they come up and the datagram is gone (or was resent with another deadline)
+    using RetransmitTimers =
+        std::priority_queue<RetransmitTimer, std::vector<RetransmitTimer>, std::greater<>>;
+} // namespace rakro
@@ -0,0 +1,201 @@
+#pragma once
+
+#include "rakro/packet/frame_set.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace rakro {
+
+    // Same idea as RakNet's PacketPriority
+    enum class SendPriority : uint8_t {
+        Immediate, // Doesnt wait for the tick, and goes out ahead of anything queued
+        High,
+        Medium,
+        Low,
+    };
+
+    // A body queued for many clients at once, every one of them holds a reference instead of
+    // a copy, see ClientRouter::broadcast
+    using SharedBody = std::shared_ptr<const std::vector<uint8_t>>;
+
+    // A frame waiting for its priority to come up. The body lives in the byte buffer of its
+    // level, offset counts from the start of that buffer's lifetime. Frames of a broadcast
+    // point into their shared body instead, offset counts from its start then
+    struct QueuedFrame {
+        packets::FrameInfo      info{};
+        size_t                  offset{0};
+        std::optional<uint32_t> receipt{}; // Unreliable frames only, see ReceiptTracker
+        SharedBody              shared{};
+    };
+
+    struct QueuedFrameView {
+        const packets::FrameInfo* info{nullptr};
+        std::span<const uint8_t>  body{};
+        std::optional<uint32_t>   receipt{};
+    };
+
+    // Frames waiting to be packed into a datagram, one queue per priority below Immediate.
+    // Which queue goes next is picked by stride scheduling, High gets 4 turns for every 2 of
+    // Medium and 1 of Low while all of them have something waiting. A queue that was empty
+    // starts at the current pass, so sitting idle doesnt build up credit
+    class PriorityFrameQueues {
+    public:
+        // Copies the body in and returns its offset for push. Split packets store the whole
+        // body once and push every fragment with an offset into it
+        size_t store(SendPriority priority, std::span<const uint8_t> body) {
+            auto&      level  = this->level_of(priority);
+            const auto offset = level.base + level.bytes.size();
+
+            level.bytes.insert(level.bytes.end(), body.begin(), body.end());
+            return offset;
+        }
+
+        // Frames of a level have to be pushed in the order their bodies were stored
+        void push(
+            SendPriority priority, const packets::FrameInfo& info, size_t offset,
+            std::optional<uint32_t> receipt = std::nullopt
+        ) {
+            auto& level = this->level_of(priority);
+
+            if (level.frames.empty()) {
+                level.pass = std::max(level.pass, this->pass);
+            }
+
+            level.frames.push_back({.info = info, .offset = offset, .receipt = receipt});
+            this->count++;
+        }
+
+        // A frame whose body is offset bytes into shared, nothing is copied. These can be
+        // mixed freely with stored ones
+        void push_shared(
+            SendPriority priority, const packets::FrameInfo& info, SharedBody shared,
+            size_t offset, std::optional<uint32_t> receipt = std::nullopt
+        ) {
+            auto& level = this->level_of(priority);
+
+            if (level.frames.empty()) {
+                level.pass = std::max(level.pass, this->pass);
+            }
+
+            level.frames.push_back({
+                .info = info, .offset = offset, .receipt = receipt, .shared = std::move(shared)
+            });
+            this->count++;
+        }
+
+        // Whatever pop would take next
+        std::optional<QueuedFrameView> peek() noexcept {
+            const auto index = this->next_level();
+            if (!index.has_value()) {
+                return std::nullopt;
+            }
+
+            auto&       level = this->levels[*index];
+            const auto& frame = level.frames.front();
+
+            const auto body =
+                frame.shared != nullptr
+                    ? std::span<const uint8_t>(*frame.shared).subspan(frame.offset)
+                    : std::span<const uint8_t>(level.bytes).subspan(frame.offset - level.base);
+
+            return QueuedFrameView{
+                .info    = &frame.info,
+                .body    = body.first(frame.info.body_leng),
+                .receipt = frame.receipt
+            };
+        }
+
+        void pop() noexcept {
+            const auto index = this->next_level();
+            if (!index.has_value()) {
+                return;
+            }
+
+            auto& level = this->levels[*index];
+
+            this->pass = level.pass;
+            level.pass += STRIDES[*index];
+            level.frames.pop_front();
+            this->count--;
+
+            if (level.frames.empty()) {
+                level.bytes.clear();
+                level.base = 0;
+                return;
+            }
+
+            // A shared body says nothing about how much of the level's bytes are used
+            if (level.frames.front().shared != nullptr) {
+                return;
+            }
+
+            // Bodies are only dropped from the front once enough is used up, so a long
+            // backlog doesnt move the rest on every pop
+            const auto used = level.frames.front().offset - level.base;
+            if (used >= COMPACT_AFTER && used * 2 >= level.bytes.size()) {
+                level.bytes.erase(
+                    level.bytes.begin(), level.bytes.begin() + static_cast<ptrdiff_t>(used)
+                );
+                level.base += used;
+            }
+        }
+
+        bool   empty() const noexcept { return this->count == 0; }
+        size_t size() const noexcept { return this->count; }
+
+        // Calls fn with the receipt of every queued frame that has one
+        template <typename Fn> void for_each_receipt(Fn&& fn) const {
+            for (const auto& level : this->levels) {
+                for (const auto& frame : level.frames) {
+                    if (frame.receipt.has_value()) {
+                        fn(*frame.receipt);
+                    }
+                }
+            }
+        }
+
+    private:
+        static constexpr size_t                  LEVEL_COUNT   = 3;
+        static constexpr std::array<uint64_t, 3> STRIDES       = {1, 2, 4}; // High first
+        static constexpr size_t                  COMPACT_AFTER = 16 * 1024;
+
+        struct Level {
+            std::deque<QueuedFrame> frames{};
+            std::vector<uint8_t>    bytes{};
+            size_t                  base{0};
+            uint64_t                pass{0};
+        };
+
+        // Immediate frames never get queued, they would be treated as High if they did
+        Level& level_of(SendPriority priority) noexcept {
+            return this->levels[std::max<size_t>(std::to_underlying(priority), 1) - 1];
+        }
+
+        // Lowest pass wins, ties go to the higher priority
+        std::optional<size_t> next_level() const noexcept {
+            auto best = std::optional<size_t>();
+
+            for (size_t index = 0; index < LEVEL_COUNT; index++) {
+                if (this->levels[index].frames.empty()) {
+                    continue;
+                }
+                if (!best.has_value() || this->levels[index].pass < this->levels[*best].pass) {
+                    best = index;
+                }
+            }
+            return best;
+        }
+
+    private:
+        std::array<Level, LEVEL_COUNT> levels{};
+        uint64_t                       pass{0}; // Pass of the last level popped
+        size_t                         count{0};
+    };
+} // namespace rakro
@@ -0,0 +1,215 @@
+#include "sequence_window.hpp"
+#include <utility>
+
+namespace rakro {
+
+    Arrival ReceiveWindow::receive(uint24_t sequence) noexcept {
+        const auto delta = sequence_delta(sequence, this->next);
+
+        if (delta < 0) {
+            if (-delta > static_cast<int32_t>(RECEIVE_WINDOW) || this->test(sequence)) {
+                return Arrival::Duplicate;
+            }
+
+            const auto position = sequence.get_value() & (RECEIVE_WINDOW - 1);
+            this->bits[position / 64] |= uint64_t{1} << (position % 64);
+            return Arrival::Late;
+        }
+
+        if (delta > this->max_gap) {
+            return Arrival::TooFarAhead;
+        }
+
+        // Those bits still describe sequence numbers a whole window back, everything up to
+        // this one is missing now, and this one is here
+        detail::for_each_word(
+            this->next.get_value(), static_cast<uint32_t>(delta) + 1, RECEIVE_WINDOW,
+            [&](uint32_t word, uint64_t mask) { this->bits[word] &= ~mask; }
+        );
+
+        const auto position = sequence.get_value() & (RECEIVE_WINDOW - 1);
+        this->bits[position / 64] |= uint64_t{1} << (position % 64);
+
+        this->next = sequence + 1;
+        return Arrival::New;
+    }
+
+    Arrival ReceiveWindow::check(uint24_t sequence) const noexcept {
+        const auto delta = sequence_delta(sequence, this->next);
+
+        if (delta < 0) {
+            return -delta > static_cast<int32_t>(RECEIVE_WINDOW) || this->test(sequence)
+                     ? Arrival::Duplicate
+                     : Arrival::Late;
+        }
+
+        return delta > this->max_gap ? Arrival::TooFarAhead : Arrival::New;
+    }
+
+    void ReceiveWindow::collect_missing(
+        packets::SequenceRange range, std::vector<packets::SequenceRange>& out
+    ) const {
+        // Only whatever is still inside the window and behind next can be missing
+        auto start = range.start;
+        if (sequence_delta(start, this->next) < -static_cast<int32_t>(RECEIVE_WINDOW)) {
+            start = this->next - RECEIVE_WINDOW;
+        }
+
+        auto last = range.end;
+        if (sequence_delta(last, this->next) >= 0) {
+            last = this->next - 1;
+        }
+
+        if (sequence_delta(last, start) < 0) {
+            return;
+        }
+
+        auto run = std::optional<packets::SequenceRange>();
+
+        for (auto sequence = start;; ++sequence) {
+            if (this->test(sequence)) {
+                if (run.has_value()) {
+                    out.push_back(run.value());
+                    run.reset();
+                }
+            } else if (run.has_value()) {
+                run->end = sequence;
+            } else {
+                run = packets::SequenceRange{.start = sequence, .end = sequence};
+            }
+
+            if (sequence == last) {
+                break;
+            }
+        }
+
+        if (run.has_value()) {
+            out.push_back(run.value());
+        }
+    }
+
+    void InFlightWindow::insert(uint24_t sequence, SentDatagram sent) {
+        if (this->count == 0) {
+            this->base = sequence;
+        }
+
+        const auto ahead = sequence_delta(sequence, this->base);
+        while (ahead >= static_cast<int32_t>(this->slots.size())) {
+            this->grow();
+        }
+
+        const auto position = this->position_of(sequence);
+
+        this->slots[position] = std::move(sent);
+        this->live[position / 64] |= uint64_t{1} << (position % 64);
+        this->end = sequence + 1;
+        this->count++;
+    }
+
+    SentDatagram* InFlightWindow::find(uint24_t sequence) noexcept {
+        if (this->count == 0 || sequence_delta(sequence, this->base) < 0 ||
+            sequence_delta(sequence, this->end) >= 0) {
+            return nullptr;
+        }
+
+        const auto position = this->position_of(sequence);
+        return this->is_live(position) ? &this->slots[position] : nullptr;
+    }
+
+    std::optional<SentDatagram> InFlightWindow::take(uint24_t sequence) noexcept {
+        if (this->find(sequence) == nullptr) {
+            return std::nullopt;
+        }
+
+        const auto position = this->position_of(sequence);
+        auto       sent     = std::exchange(this->slots[position], SentDatagram());
+
+        this->live[position / 64] &= ~(uint64_t{1} << (position % 64));
+        this->count--;
+        this->advance_base();
+
+        return sent;
+    }
+
+    void
+    InFlightWindow::collect(packets::SequenceRange range, std::vector<uint24_t>& out) const {
+        const auto span = this->clamp(range);
+        if (!span.has_value()) {
+            return;
+        }
+
+        const auto capacity = static_cast<uint32_t>(this->slots.size());
+
+        detail::for_each_word(
+            span->start.get_value(), span->size(), capacity,
+            [&](uint32_t word, uint64_t mask) {
+                auto hits = this->live[word] & mask;
+
+                while (hits != 0) {
+                    const auto position =
+                        word * 64 + static_cast<uint32_t>(std::countr_zero(hits));
+                    hits &= hits - 1;
+
+                    out.push_back(
+                        span->start + ((position - span->start.get_value()) & (capacity - 1))
+                    );
+                }
+            }
+        );
+    }
+
+    std::optional<packets::SequenceRange>
+    InFlightWindow::clamp(packets::SequenceRange range) const noexcept {
+        if (this->count == 0) {
+            return std::nullopt;
+        }
+
+        auto start = range.start;
+        if (sequence_delta(start, this->base) < 0) {
+            start = this->base;
+        }
+
+        auto last = range.end;
+        if (sequence_delta(last, this->end) >= 0) {
+            last = this->end - 1;
+        }
+
+        if (sequence_delta(last, start) < 0) {
+            return std::nullopt;
+        }
+
+        return packets::SequenceRange{.start = start, .end = last};
+    }
+
+    void InFlightWindow::grow() {
+        const auto capacity = this->slots.size() * 2;
+
+        auto slots = std::vector<SentDatagram>(capacity);
+        auto live  = std::vector<uint64_t>(capacity / 64);
+
+        for (auto sequence = this->base; sequence != this->end; ++sequence) {
+            const auto from = this->position_of(sequence);
+            if (!this->is_live(from)) {
+                continue;
+            }
+
+            const auto to = sequence.get_value() & static_cast<uint32_t>(capacity - 1);
+            slots[to]     = std::move(this->slots[from]);
+            live[to / 64] |= uint64_t{1} << (to % 64);
+        }
+
+        this->slots = std::move(slots);
+        this->live  = std::move(live);
+    }
+
+    void InFlightWindow::advance_base() noexcept {
+        if (this->count == 0) {
+            this->base = this->end;
+            return;
+        }
+
+        while (!this->is_live(this->position_of(this->base))) {
+            ++this->base;
+        }
+    }
+} // namespace rakro
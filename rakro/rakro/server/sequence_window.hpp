@@ -0,0 +1,195 @@
+#pragma once
+
+#include "rakro/internal/int24_t.hpp"
+#include "rakro/packet/ack_records.hpp"
+#include "rakro/server/retransmit.hpp"
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace rakro {
+
+    // How far a datagram sequence number may jump ahead of what we expect before we call it
+    // garbage
+    constexpr int32_t MAX_SEQUENCE_GAP = 4096;
+    // How many sequence numbers back we remember, anything older is treated as a duplicate
+    constexpr uint32_t RECEIVE_WINDOW = 8192;
+    // Most datagrams a connection can have in flight, the window stops sending past this
+    constexpr uint32_t MAX_IN_FLIGHT = 8192;
+    // Reliable frame indices can run further ahead than datagrams, several frames share a
+    // datagram. Anything up to a whole window ahead still gets tracked
+    constexpr int32_t MAX_RELIABLE_GAP = static_cast<int32_t>(RECEIVE_WINDOW) - 1;
+
+    static_assert(RECEIVE_WINDOW % 64 == 0 && (RECEIVE_WINDOW & (RECEIVE_WINDOW - 1)) == 0);
+    static_assert(static_cast<uint32_t>(MAX_SEQUENCE_GAP) < RECEIVE_WINDOW);
+    static_assert(static_cast<uint32_t>(MAX_RELIABLE_GAP) < RECEIVE_WINDOW);
+
+    namespace detail {
+        // Calls fn(word, mask) for every 64 bit word that bits [first, first + count) of a
+        // ring of ring_bits bits touch, ring_bits has to be a power of two of at least 64
+        template <typename Fn>
+        void for_each_word(uint32_t first, uint32_t count, uint32_t ring_bits, Fn&& fn) {
+            auto position = first & (ring_bits - 1);
+
+            while (count != 0) {
+                const auto offset = position % 64;
+                const auto bits   = std::min(count, 64 - offset);
+                const auto mask   = (bits == 64 ? ~uint64_t{0} : ((uint64_t{1} << bits) - 1))
+                                  << offset;
+
+                fn(position / 64, mask);
+
+                position = (position + bits) & (ring_bits - 1);
+                count -= bits;
+            }
+        }
+    } // namespace detail
+
+    enum class Arrival : uint8_t {
+        New,        // At or past the next expected one, anything skipped is now missing
+        Late,       // One of the missing ones
+        Duplicate,  // Got it already, or it is too old to tell
+        TooFarAhead // Further ahead than the window was told to accept
+    };
+
+    // Copies that got dropped on arrival, mostly resends of things whose ack got lost
+    struct DuplicateStats {
+        uint64_t datagrams{0};
+        uint64_t frames{0}; // Reliable frames seen before, even if the datagram was new
+    };
+
+    // Which of the last RECEIVE_WINDOW sequence numbers have arrived, one bit each. Used for
+    // datagram sequence numbers and reliable frame indices. Moving the window forward clears
+    // the bits it passes over in whole words
+    class ReceiveWindow {
+    public:
+        explicit ReceiveWindow(int32_t max_gap = MAX_SEQUENCE_GAP) : max_gap(max_gap) {}
+
+        Arrival  receive(uint24_t sequence) noexcept;
+        uint24_t get_next() const noexcept { return this->next; }
+
+        // What receive would say, without marking anything
+        Arrival check(uint24_t sequence) const noexcept;
+
+        // Appends the runs inside range that still havent arrived to out
+        void
+        collect_missing(packets::SequenceRange range, std::vector<packets::SequenceRange>& out)
+            const;
+
+    private:
+        bool test(uint24_t sequence) const noexcept {
+            const auto position = sequence.get_value() & (RECEIVE_WINDOW - 1);
+            return (this->bits[position / 64] >> (position % 64)) & 1;
+        }
+
+    private:
+        // Everything before the first datagram counts as received, so nothing from before the
+        // connection started gets nacked
+        std::array<uint64_t, RECEIVE_WINDOW / 64> bits{[] {
+            std::array<uint64_t, RECEIVE_WINDOW / 64> all{};
+            all.fill(~uint64_t{0});
+            return all;
+        }()};
+        uint24_t next{0};
+        int32_t  max_gap{MAX_SEQUENCE_GAP};
+    };
+
+    // Unacked reliable datagrams, in a ring indexed by sequence number with a bit per slot
+    // saying whether it is still live. Starts small and doubles up to MAX_IN_FLIGHT
+    class InFlightWindow {
+    public:
+        InFlightWindow() : slots(MIN_SLOTS), live(MIN_SLOTS / 64) {}
+
+        // Sequence numbers have to be inserted in the order they are sent. Skipping some is
+        // fine, unreliable datagrams use them up too
+        bool has_room(uint24_t sequence) const noexcept {
+            return this->count == 0 ||
+                   sequence_delta(sequence, this->base) < static_cast<int32_t>(MAX_IN_FLIGHT);
+        }
+
+        void insert(uint24_t sequence, SentDatagram sent);
+
+        // nullptr unless sequence is in flight
+        SentDatagram* find(uint24_t sequence) noexcept;
+
+        std::optional<SentDatagram> take(uint24_t sequence) noexcept;
+
+        // Takes everything in range that is in flight, fn gets called with each sequence number
+        // and its datagram. fn must not touch the window
+        template <typename Fn> void take_range(packets::SequenceRange range, Fn&& fn) {
+            const auto span = this->clamp(range);
+            if (!span.has_value()) {
+                return;
+            }
+
+            const auto capacity = static_cast<uint32_t>(this->slots.size());
+
+            detail::for_each_word(
+                span->start.get_value(), span->size(), capacity,
+                [&](uint32_t word, uint64_t mask) {
+                    auto hits = this->live[word] & mask;
+                    this->live[word] &= ~mask;
+
+                    while (hits != 0) {
+                        const auto position =
+                            word * 64 + static_cast<uint32_t>(std::countr_zero(hits));
+                        hits &= hits - 1;
+
+                        // Ring position back to sequence number, relative to the span start
+                        const auto offset =
+                            (position - span->start.get_value()) & (capacity - 1);
+                        fn(span->start + offset, std::move(this->slots[position]));
+                        this->slots[position] = SentDatagram();
+                        this->count--;
+                    }
+                }
+            );
+
+            this->advance_base();
+        }
+
+        // Appends the sequence numbers in range that are in flight to out
+        void collect(packets::SequenceRange range, std::vector<uint24_t>& out) const;
+
+        // Calls fn with every datagram in flight, in no particular order
+        template <typename Fn> void for_each(Fn&& fn) const {
+            for (size_t word = 0; word < this->live.size(); word++) {
+                auto hits = this->live[word];
+
+                while (hits != 0) {
+                    fn(this->slots[word * 64 + static_cast<size_t>(std::countr_zero(hits))]);
+                    hits &= hits - 1;
+                }
+            }
+        }
+
+        size_t size() const noexcept { return this->count; }
+
+    private:
+        static constexpr uint32_t MIN_SLOTS = 64;
+
+        // range cut down to [base, end), nullopt if nothing is left
+        std::optional<packets::SequenceRange>
+        clamp(packets::SequenceRange range) const noexcept;
+
+        bool is_live(uint32_t position) const noexcept {
+            return (this->live[position / 64] >> (position % 64)) & 1;
+        }
+
+        uint32_t position_of(uint24_t sequence) const noexcept {
+            return sequence.get_value() & static_cast<uint32_t>(this->slots.size() - 1);
+        }
+
+        void grow();
+        void advance_base() noexcept;
+
+    private:
+        std::vector<SentDatagram> slots{};
+        std::vector<uint64_t>     live{};
+        uint24_t                  base{0}; // Oldest sequence that might still be live
+        uint24_t                  end{0};  // One past the newest inserted
+        size_t                    count{0};
+    };
+} // namespace rakro
@@ -1,11 +1,9 @@
 #include "server.hpp"
 #include "rakro/internal/binary_buffer.hpp"
 #include "rakro/internal/net.hpp"
-#include <algorithm>
 #include <array>
 #include <atomic>
 #include <format>
-#include <print>
 #include <rakro/packet/incompatible_protocol.hpp>
 #include <rakro/packet/open_connection_reply_one.hpp>
 #include <rakro/packet/open_connection_reply_two.hpp>
@@ -21,18 +19,6 @@
 
 namespace rakro {
 
-    bool RakServer::is_trivial_packet(BinaryBuffer& buffer) noexcept {
-
-        constexpr std::array<uint8_t, 4> trival_packets = {
-            std::to_underlying(PacketId::UnconnectedPing1),
-            std::to_underlying(PacketId::UnconnectedPing2),
-            std::to_underlying(PacketId::OpenConnectionRequest1),
-            std::to_underlying(PacketId::OpenConnectionRequest2)
-        };
-
-        return std::ranges::contains(trival_packets, buffer.read_next_peak<uint8_t>());
-    }
-
     void RakServer::start() {
         this->listener_thread = std::thread([this] { this->process_packets(); });
     }
@@ -41,6 +27,37 @@ namespace rakro {
         this->server_start_time = detail::time_since_epoch();
 
         while (this->running.load(std::memory_order_relaxed)) {
+            // Handshakes waiting their turn shouldnt also wait out the socket timeout
+            const auto count = this->receive_batch(this->admission.empty());
+
+            if (count != 0) {
+                this->dispatch_batch(count);
+            }
+
+            this->admit();
+            this->update();
+        }
+    }
+
+    void RakServer::update() {
+        const auto now = detail::time_since_epoch();
+
+        if (now - this->last_update < this->update_interval_ms) {
+            return;
+        }
+
+        this->last_update = now;
+        this->router.update(now);
+    }
+
+    size_t RakServer::receive_batch(bool block) {
+        if (!block && !this->server_socket.has_pending()) {
+            return 0;
+        }
+
+        size_t count = 0;
+
+        do {
             auto raw_data  = this->renter.rent(); // larger than the max MTU
             auto data_recv = this->server_socket.recv_value(raw_data.get_memory());
 
@@ -53,8 +70,7 @@ namespace rakro {
                 }
 
                 if (error_code == WSAETIMEDOUT) {
-                    continue; // Just means no packet has hit the server in 2 seconds, just
-                              // restart
+                    continue; // Nothing arrived within the update interval, go tick
                 }
 
                 throw std::runtime_error(std::format("Unknown socket error! {}", error_code));
@@ -64,24 +80,89 @@ namespace rakro {
                 continue; // empty packet, might be a scanner
             }
 
-            auto buffer = BinaryBuffer(std::move(raw_data), data_recv->first);
+            auto& buffer = this->ingress_buffers[count];
+            buffer       = BinaryBuffer(std::move(raw_data), data_recv->first);
 
-            if (this->is_trivial_packet(buffer)) {
-                if (!this->handle_packet(buffer, data_recv.value().second)) {
-                    std::println("Unhandled packet: {:x}", buffer.underlying()[0]);
-                }
+            this->ingress_addresses[count]   = data_recv->second;
+            this->ingress_views[count]       = buffer.underlying();
+            this->ingress_received_us[count] = detail::monotonic_micros();
+            count++;
+        } while (count < MAX_INGRESS_BATCH && this->server_socket.has_pending());
+
+        return count;
+    }
+
+    void RakServer::dispatch_batch(size_t count) {
+        const auto buffers = std::span(this->ingress_buffers).subspan(0, count);
+
+        classify_ingress(
+            std::span(this->ingress_views).subspan(0, count), this->ingress_classes
+        );
+
+        // Connected traffic goes first, handshakes only get what is left of the pass. A
+        // client that connects in this batch doesnt send a frame set before it has its OCR2
+        // reply anyway
+        constexpr std::array connected_buckets = {
+            IngressBucket::FrameSet, IngressBucket::Ack, IngressBucket::Nack
+        };
+
+        auto& connected = this->lanes[static_cast<size_t>(IngressLane::Connected)];
+
+        for (const auto bucket : connected_buckets) {
+            for (const auto index : this->ingress_classes.bucket(bucket)) {
+                this->router.route(this->ingress_addresses[index], std::move(buffers[index]));
+                connected.record(this->ingress_received_us[index], detail::monotonic_micros());
+            }
+        }
+
+        this->router.wake();
+
+        const auto now = detail::time_since_epoch();
+
+        for (const auto index : this->ingress_classes.bucket(IngressBucket::Unconnected)) {
+            // Over the limit means no parsing and no reply, the buffer goes back untouched
+            if (!this->limiter.allow(this->ingress_addresses[index], now)) {
                 continue;
             }
 
-            this->router.route(data_recv.value().second, std::move(buffer));
+            const auto queued = this->admission.push(
+                buffers[index], this->ingress_addresses[index], this->ingress_received_us[index]
+            );
+
+            if (!queued) {
+                this->lanes[static_cast<size_t>(IngressLane::Unconnected)].drop();
+            }
+        }
+
+        // Garbage is never looked at, and this hands every rented buffer back to the company
+        for (auto& buffer : buffers) {
+            buffer = BinaryBuffer();
         }
     }
 
+    void RakServer::admit() {
+        auto& unconnected = this->lanes[static_cast<size_t>(IngressLane::Unconnected)];
+
+        this->admission.drain(
+            [&](BinaryBuffer& buffer, detail::IPV4Addr& address, uint64_t received_us) {
+                // Anyone can send these, so they only ever reach the debugger
+                if (!this->handle_packet(buffer, address) && this->instrument) {
+                    this->instrument->warning_log(std::format(
+                        "Unhandled unconnected packet: {:x}", buffer.underlying()[0]
+                    ));
+                }
+                unconnected.record(received_us, detail::monotonic_micros());
+            }
+        );
+    }
+
     bool RakServer::handle_packet(BinaryBuffer& buffer, detail::IPV4Addr& address) {
         const auto id = static_cast<PacketId>(buffer.read_next<uint8_t>());
 
         switch (id) {
-        case PacketId::UnconnectedPing1: {
+        // Ping2 only asks for a pong if there are open slots, which there always are here
+        case PacketId::UnconnectedPing1:
+        case PacketId::UnconnectedPing2: {
             (void)buffer.read_next<packets::UnconnectedPing>();
 
             buffer.clear();
@@ -92,40 +173,80 @@ namespace rakro {
         }
         case PacketId::OpenConnectionRequest1: {
             const auto ocr = buffer.read_next<packets::OpenConnectionRequest1>();
+            const auto now = detail::time_since_epoch();
+            const auto mtu = this->clamp_mtu(ocr.mtu);
             buffer.clear();
 
             if (ocr.proto_version != this->protocol_version) {
                 buffer.write(packets::IncompatibleProtocol(ocr.proto_version, this->server_guid)
                 );
+            } else if (this->cookies.has_value()) {
+                // Nothing is stored, OCR2 has to bring the cookie back
+                buffer.write(packets::OpenConnectionReply1{
+                    .server_guid = this->server_guid,
+                    .MTU         = mtu,
+                    .cookie      = this->cookies->issue(address, now)
+                });
             } else {
-                buffer.write(packets::OpenConnectionReply1(this->server_guid, ocr.mtu));
+                buffer.write(packets::OpenConnectionReply1(this->server_guid, mtu));
+
+                // Kept past OCR2 too, a client whose reply got lost just sends OCR2 again
+                this->half_open.insert(address, mtu, now);
             }
 
             this->send_to(buffer.consumed_slice(), address, PacketId::OpenConnectionReply1);
-
-            this->mid_connection_clients[address] = {
-                .connection_time = detail::time_since_epoch(), .mtu = ocr.mtu
-            };
-
             return true;
         }
         case PacketId::OpenConnectionRequest2: {
             const auto ocr2 = buffer.read_next<packets::OpenConnectionRequest2>();
+            const auto now  = detail::time_since_epoch();
 
-            if (!this->mid_connection_clients.contains(address))
-                return true; // Means this address hasnt sent ocr1
+            auto mid = std::optional<SemiConnectedClient>();
 
-            const auto mid = this->mid_connection_clients[address];
+            if (this->cookies.has_value()) {
+                if (ocr2.cookie.has_value() &&
+                    this->cookies->check(address, ocr2.cookie.value(), now)) {
+                    // Only the MTU the client asks for here is left to go on, OCR1 wasnt kept
+                    mid = SemiConnectedClient{
+                        .connection_time = now, .mtu = this->clamp_mtu(ocr2.mtu)
+                    };
+                }
+            } else {
+                mid = this->half_open.find(address, now);
+            }
+
+            if (!mid.has_value()) {
+                return true; // Means this address hasnt sent ocr1, or not lately
+            }
 
-            this->router.connect_client(
-                &this->server_socket, address, mid, ocr2.client_guid, this->instrument.get(),
-                &this->renter, this->server_start_time
+            // Whatever the client asks for now, never more than we agreed to or can take. The
+            // reply carries the same value the session is created with
+            mid->mtu = std::min(mid->mtu, this->clamp_mtu(ocr2.mtu));
+
+            const auto connected = this->router.connect(
+                address, mid.value(), ocr2.client_guid,
+                ClientSettings{
+                    .socket            = &this->server_socket,
+                    .debugger          = this->instrument.get(),
+                    .company           = &this->renter,
+                    .server_start_time = this->server_start_time,
+                    .codecs            = &this->codecs,
+                    .payload           = this->payload_settings,
+                    .congestion        = this->congestion,
+                    .scratch           = &this->scratch
+                }
             );
 
+            // No reply, so the client doesnt think it has a session. It sends OCR2 again, and
+            // the half open entry or the cookie is still good for it
+            if (!connected) {
+                return true;
+            }
+
             buffer.clear();
 
             buffer.write(packets::OpenConnectionReply2{
-                this->server_guid, ocr2.mtu, packets::RakAddress::from_ipv4(address)
+                this->server_guid, mid->mtu, packets::RakAddress::from_ipv4(address)
             });
 
             this->send_to(buffer.consumed_slice(), address, PacketId::OpenConnectionReply2);
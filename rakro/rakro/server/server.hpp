@@ -4,11 +4,18 @@
 #include "rakro/internal/buffer_company.hpp"
 #include "rakro/internal/net.hpp"
 #include "rakro/packet/packet_id.hpp"
+#include "rakro/server/admission.hpp"
 #include "rakro/server/debug_instrument.hpp"
+#include "rakro/server/handshake.hpp"
+#include "rakro/server/ingress.hpp"
+#include "rakro/server/rate_limit.hpp"
+#include "rakro/server/shards.hpp"
 #include "server_client.hpp"
+#include <algorithm>
+#include <array>
 #include <memory>
+#include <optional>
 #include <thread>
-#include <unordered_map>
 
 namespace rakro {
 
@@ -16,6 +23,32 @@ namespace rakro {
         size_t rented_buffer_count       = 512;
         size_t rented_buffer_size        = 2048; // Shouldnt be changed past maybe 1520
         size_t rented_block_buffer_count = 4;
+        // What new connections start with, see PayloadSettings
+        PayloadSettings payload{};
+        // How often queued frames get flushed, also the longest the socket blocks for
+        uint32_t update_interval_ms = 10;
+        // Picked per connection when it is accepted
+        CongestionAlgorithm congestion = CongestionAlgorithm::SlidingWindow;
+        // Threads connections are spread over, 0 keeps them on the listener thread. Debugger
+        // hooks for connected clients run on these too. Their queues share half the rented
+        // buffers, a lot of workers on a small pool get shorter queues, see
+        // shard_queue_capacity
+        size_t worker_count = 0;
+        // OCR1 is answered with a cookie OCR2 has to echo, nothing is stored for an address
+        // until it does. Off by default, it needs clients that handle the security flag
+        bool handshake_cookies = false;
+        // Addresses between OCR1 and OCR2 remembered at once with cookies off, see
+        // HalfOpenTable
+        size_t max_half_open = 4096;
+        // Applied to unconnected pings and handshake packets before they are parsed
+        RateLimitSettings rate_limit{};
+        // How many of the pings and handshakes that got past the rate limit can wait, and how
+        // many are handled per pass once connected traffic went first
+        AdmissionSettings admission{};
+        // Scratch memory every connection together may reserve for split packets being put
+        // back together. Fragments of a new one are turned away unacked past this, the client
+        // resends them later
+        size_t max_reassembly_bytes = size_t{1} << 28;
     };
 
     class RakServer {
@@ -25,7 +58,24 @@ namespace rakro {
               renter(
                   config.rented_buffer_count, config.rented_buffer_size,
                   config.rented_block_buffer_count
-              ) {}
+              ),
+              scratch(config.max_reassembly_bytes), payload_settings(config.payload),
+              update_interval_ms(config.update_interval_ms),
+              congestion(config.congestion), half_open(config.max_half_open),
+              max_mtu(config.rented_buffer_size), limiter(config.rate_limit),
+              admission(config.admission),
+              router(
+                  config.worker_count, config.update_interval_ms,
+                  shard_queue_capacity(this->renter, config.worker_count)
+              ) {
+            if (config.handshake_cookies) {
+                this->cookies.emplace();
+            }
+
+            // 0 would mean block forever
+            const auto timeout = std::max(this->update_interval_ms, uint32_t{1});
+            this->server_socket.set_recv_timeout(timeout);
+        }
 
         RakServer(RakServer&&) = delete;
 
@@ -39,27 +89,151 @@ namespace rakro {
             this->instrument = std::move(debugger);
         }
 
+        // Fills out with whatever happened since the last call, connections, disconnections,
+        // game packets and receipts, and returns how many. Call it from one thread only,
+        // message payloads stay valid until the next call
+        size_t poll(std::span<Event> out) { return this->router.poll(out); }
+
+        // Safe from any number of threads at once. The payload is copied before this returns
+        // and goes out on the client's next tick, as a game batch of one if the client's
+        // PayloadSettings are enabled. False if its worker's outbox was full
+        bool send(
+            const ClientHandle& client, std::span<const uint8_t> payload,
+            packets::FrameReliability rely = packets::FrameReliability::ReliableOrdered,
+            uint8_t channel = 0, SendPriority priority = SendPriority::Medium
+        ) {
+            const auto message = OutgoingMessage{
+                .client   = client,
+                .payload  = payload,
+                .rely     = rely,
+                .channel  = channel,
+                .priority = priority,
+            };
+            return this->router.send(std::span(&message, 1)) == 1;
+        }
+
+        // Same for a whole tick's worth, every worker's outbox is synchronised with once per
+        // call rather than once per message. Returns how many were queued
+        size_t send(std::span<const OutgoingMessage> messages) {
+            return this->router.send(messages);
+        }
+
+        // Sends payload to every one of clients, it is copied once and every client's queue
+        // only holds a reference to it. Clients with the pipeline on share one batch per
+        // distinct PayloadSettings. Same threading as send, false if some worker's outbox was
+        // full
+        bool broadcast(
+            std::span<const uint8_t> payload, packets::FrameReliability rely, uint8_t channel,
+            std::span<const ClientHandle> clients, SendPriority priority = SendPriority::Medium
+        ) {
+            return this->router.broadcast(
+                make_broadcast(payload, rely, channel, priority), clients, false
+            );
+        }
+
+        // Same, but to every client the game was told is connected, except for the ones in
+        // excluded
+        bool broadcast_except(
+            std::span<const uint8_t> payload, packets::FrameReliability rely, uint8_t channel,
+            std::span<const ClientHandle> excluded = {},
+            SendPriority                  priority = SendPriority::Medium
+        ) {
+            return this->router.broadcast(
+                make_broadcast(payload, rely, channel, priority), excluded, true
+            );
+        }
+
+        // Swaps the PayloadSettings of one client, once the game negotiated compression with
+        // it for one. Same threading as send, whatever was sent to client before this still
+        // goes out with the old settings. False if its worker's outbox was full
+        bool
+        update_payload_settings(const ClientHandle& client, const PayloadSettings& settings) {
+            return this->router.update_payload_settings(client, settings);
+        }
+
+        // Datagrams the workers got through or turned away, and game packets dropped because
+        // poll wasnt called often enough, from any thread
+        ShardStats get_router_stats() const noexcept { return this->router.get_stats(); }
+
+        // Unconnected datagrams let through and dropped so far, from any thread
+        RateLimitStats get_rate_limit_stats() const noexcept {
+            return this->limiter.get_stats();
+        }
+
+        // How many datagrams each lane got through and how long they waited, from any thread
+        LaneStats get_lane_stats(IngressLane lane) const noexcept {
+            return this->lanes[static_cast<size_t>(lane)].get();
+        }
+
     private:
-        static bool is_trivial_packet(BinaryBuffer& buffer) noexcept;
+        static Broadcast make_broadcast(
+            std::span<const uint8_t> payload, packets::FrameReliability rely, uint8_t channel,
+            SendPriority priority
+        ) {
+            return Broadcast{
+                .body     = std::make_shared<const std::vector<uint8_t>>(
+                    payload.begin(), payload.end()
+                ),
+                .rely     = rely,
+                .channel  = channel,
+                .priority = priority,
+            };
+        }
 
         void process_packets();
 
+        // Blocks for one datagram unless block is unset, then drains whatever else is already
+        // queued on the socket into the ingress batch. Returns how many slots of the batch
+        // are filled
+        size_t receive_batch(bool block);
+
+        void dispatch_batch(size_t count);
+
+        // Handles this pass's share of the admission lane
+        void admit();
+
+        // Flushes queued frames once per update interval
+        void update();
+
         bool handle_packet(BinaryBuffer& buffer, detail::IPV4Addr& address);
 
+        // An MTU a client asked for, cut down to what fits a rented buffer
+        uint16_t clamp_mtu(uint16_t mtu) const noexcept {
+            return static_cast<uint16_t>(std::min<size_t>(mtu, this->max_mtu));
+        }
+
         void
         send_to(std::span<uint8_t> buffer, detail::IPV4Addr& address, PacketId sending_packet);
 
     private:
-        detail::UdpSocket                         server_socket;
-        std::thread                               listener_thread;
-        std::atomic_bool                          running{true};
-        uint8_t                                   protocol_version{6}; // 11
-        std::atomic<std::shared_ptr<std::string>> server_id{};
-        uint64_t                                  server_guid{0xDEADC0DEAF012313};
-        std::unordered_map<detail::IPV4Addr, SemiConnectedClient> mid_connection_clients{};
-        std::unique_ptr<IRakServerDebugInstrument>                instrument{nullptr};
-        uint64_t                                                  server_start_time{};
-        BufferCompany                                             renter{};
-        ClientRouter                                              router{};
+        detail::UdpSocket                          server_socket;
+        std::thread                                listener_thread;
+        std::atomic_bool                           running{true};
+        uint8_t                                    protocol_version{6}; // 11
+        std::atomic<std::shared_ptr<std::string>>  server_id{};
+        uint64_t                                   server_guid{0xDEADC0DEAF012313};
+        std::unique_ptr<IRakServerDebugInstrument> instrument{nullptr};
+        uint64_t                                   server_start_time{};
+        BufferCompany                              renter{};
+        CodecPool                                  codecs{};
+        ScratchPool                                scratch{};
+        PayloadSettings                            payload_settings{};
+        uint32_t                                   update_interval_ms{10};
+        uint64_t                                   last_update{};
+        CongestionAlgorithm                        congestion{};
+        HalfOpenTable                              half_open;
+        std::optional<HandshakeCookies>            cookies{};
+        size_t                                     max_mtu{}; // Rented buffer size
+        SourceRateLimiter                          limiter;
+        AdmissionLane                              admission;
+        ShardedRouter                              router;
+
+        std::array<LaneCounters, INGRESS_LANE_COUNT> lanes{};
+
+        std::array<BinaryBuffer, MAX_INGRESS_BATCH>             ingress_buffers{};
+        std::array<detail::IPV4Addr, MAX_INGRESS_BATCH>         ingress_addresses{};
+        std::array<std::span<const uint8_t>, MAX_INGRESS_BATCH> ingress_views{};
+        std::array<uint64_t, MAX_INGRESS_BATCH>                 ingress_received_us{};
+        IngressClassification                                   ingress_classes{};
     };
 } // namespace rakro
\ No newline at end of file
@@ -3,19 +3,41 @@
 #include "rakro/internal/buffer_company.hpp"
 #include "rakro/internal/net.hpp"
 #include "rakro/packet/ack.hpp"
+#include "rakro/packet/ack_records.hpp"
+#include "rakro/packet/nack.hpp"
 #include "rakro/packet/connected_ping_pong.hpp"
 #include "rakro/packet/connection_request.hpp"
 #include "rakro/packet/connection_request_accepted.hpp"
 #include "rakro/packet/packet_id.hpp"
 #include "rakro/packet/rak_address.hpp"
-#include <print>
+#include <algorithm>
+#include <array>
+#include <format>
+#include <limits>
 #include <rakro/internal/assert.hpp>
+#include <rakro/packet/frame_decoder.hpp>
 #include <rakro/packet/frame_set.hpp>
 #include <stdexcept>
 
 namespace rakro {
 
-    void RakroServerClient::process_frame(BinaryBuffer packet_data, packets::FrameInfo info) {
+    namespace {
+        // Room for the packets we answer with ourselves, ConnectionRequestAccepted is the
+        // biggest at 166 bytes. They are copied on the way out, so the stack will do
+        constexpr size_t CONTROL_PACKET_SIZE = 256;
+    } // namespace
+
+    void RakroServerClient::process_frame(
+        BinaryBuffer packet_data, packets::FrameInfo info, RentedScratch* owned
+    ) {
+        if (info.order_info.has_value() &&
+            info.order_info->order_channel >= MAX_ORDER_CHANNELS) {
+            if (this->debugger) {
+                this->debugger->on_invalid_frame(packet_data.underlying(), this->address);
+            }
+            return;
+        }
+
         if (info.sequence_frame_index.has_value()) {
             if (this->debugger) {
                 this->debugger->warning_log(
@@ -27,19 +49,23 @@ namespace rakro {
 
             const auto order_seq_index = info.order_info->order_channel;
 
-            const auto fire_debug = [&](uint32_t expected) {
+            const auto fire_debug = [&](uint24_t expected) {
                 if (this->debugger) {
                     debugger->on_out_of_order_seq_recv(
-                        packet_data.underlying(), info, expected
+                        packet_data.underlying(), info, expected.get_value()
                     );
                 }
             };
 
-            bool valid_seq = this->sequenced_packets_next_packet[order_seq_index] <=
-                             info.sequence_frame_index->get_value();
+            bool valid_seq = sequence_delta(
+                                 info.sequence_frame_index.value(),
+                                 this->sequenced_packets_next_packet[order_seq_index]
+                             ) >= 0;
 
-            bool valid_ord = this->ordered_buffer_next_packets[order_seq_index] <=
-                             info.order_info->order_frame_index.get_value();
+            bool valid_ord = sequence_delta(
+                                 info.order_info->order_frame_index,
+                                 this->ordering.get_next(order_seq_index)
+                             ) >= 0;
 
             // If we have a packet that is invalid in some form, bail
             if (!valid_seq || !valid_ord) {
@@ -47,79 +73,58 @@ namespace rakro {
                 return;
             }
             this->sequenced_packets_next_packet[order_seq_index] =
-                info.sequence_frame_index->get_value() + 1;
-            this->process_data(std::move(packet_data));
+                info.sequence_frame_index.value() + 1;
+            this->process_data(std::move(packet_data), order_seq_index);
             return;
 
         } else if (info.order_info.has_value()) {
             const auto order_channel = info.order_info->order_channel;
-            auto key = construct_order_key(order_channel, info.order_info->order_frame_index);
-
-            if (this->ordered_buffer_next_packets[order_channel] ==
-                info.order_info->order_frame_index.get_value()) {
-                // This is the packet we wanted next
-
-                this->ordered_buffer_next_packets[order_channel]++;
-
-                this->process_data(std::move(packet_data));
-
-                while (this->out_of_order_packet_buffer.contains(key)) {
-                    const auto val = this->out_of_order_packet_buffer.extract(key);
-
-                    this->process_data(std::move(val.mapped().raw_data));
-
-                    key = construct_order_key(
-                        order_channel,
-                        val.mapped().packet_info.order_info->order_frame_index.get_value()
-                    );
 
-                    this->ordered_buffer_next_packets[order_channel]++; // bumps to the enxt
-                                                                        // packet
-                }
-
-            } else {
-                // This packet arrived out-of-order
-
-                if (this->ordered_buffer_next_packets[order_channel] >
-                    info.order_info->order_frame_index.get_value()) {
-                    return; // Means it arrived later than another packet
-                }
+            const auto outcome = this->ordering.receive(
+                order_channel, info.order_info->order_frame_index,
+                packet_data.remaining_slice(), owned,
+                [&](BinaryBuffer frame) { this->process_data(std::move(frame), order_channel); }
+            );
 
+            switch (outcome) {
+            case OrderOutcome::Held: {
                 this->sequenced_packets_next_packet[order_channel] =
                     0; // Have no reason why this is here, just saw it in another implementation
                        // lol
-
-                // Handles a case where a bug causes us to not have removed the packet from our
-                // buffer
-                if (this->out_of_order_packet_buffer.contains(key)) {
-                    if (this->debugger) {
-                        if (!this->debugger->unexpected_exist_of_data_in_oof_buffer(
-                                packet_data.underlying(), info
-                            ))
-                            return;
-                    }
-
-                    throw std::logic_error(std::format(
-                        "Out-of-order key already exists in ordering, in the {} channel, and "
-                        "of index {}",
-                        order_channel, info.order_info->order_frame_index.get_value()
+                break;
+            }
+            case OrderOutcome::TooFarAhead:
+            case OrderOutcome::Full: {
+                // Reliable frames were turned away by can_take already, so this was sent
+                // unreliable and can go
+                if (this->debugger) {
+                    this->debugger->warning_log(std::format(
+                        "Dropped ordered frame {} on channel {}, expected {} and holding {}",
+                        info.order_info->order_frame_index.get_value(), order_channel,
+                        this->ordering.get_next(order_channel).get_value(),
+                        this->ordering.get_held()
                     ));
                 }
-
-                auto reorder_info = PacketInformation(std::move(packet_data), std::move(info));
-
-                this->out_of_order_packet_buffer.insert({key, std::move(reorder_info)});
+                break;
             }
+            case OrderOutcome::Delivered:
+            case OrderOutcome::Stale: {
+                break;
+            }
+            }
+            return;
         }
 
         this->process_data(std::move(packet_data));
     }
 
-    void RakroServerClient::process_data(BinaryBuffer buffer) {
+    void RakroServerClient::process_data(BinaryBuffer buffer, uint8_t channel) {
         if (this->debugger) {
             this->debugger->on_client_recv(buffer.remaining_slice());
         }
 
+        const auto body = buffer.remaining_slice();
+
         const auto packet_id = static_cast<PacketId>(buffer.read_next<uint8_t>());
 
         switch (packet_id) {
@@ -138,45 +143,77 @@ namespace rakro {
                 .server_up_time  = detail::time_since_epoch() - this->server_start_time
             };
 
-            auto send_buffer = BinaryBuffer(this->company->rent());
+            auto memory      = std::array<uint8_t, CONTROL_PACKET_SIZE>{};
+            auto send_buffer = BinaryBuffer(RentedBuffer(memory, nullptr));
 
             send_buffer.write(std::move(response));
-            this->send_to(this->ready_buffer(send_buffer, packets::FrameReliability::Reliable));
+            this->send_frame(
+                send_buffer, packets::FrameReliability::Reliable, SendPriority::Immediate
+            );
             break;
         }
         case PacketId::NewIncommingConnection: {
-            break; // So basically, by this point we are already connected. and there is no
-                   // information in this packet we care about, so we can just drop it and
-                   // pretend it isnt a thing
+            // Nothing in here we care about, it just means the client is done connecting
+            if (!this->announced && this->events) {
+                this->announced = true;
+                this->events->push(
+                    Event{.type = EventType::Connected, .client = this->handle()}
+                );
+            }
+            break;
+        }
+        case PacketId::DisconnectionNotification: {
+            this->disconnect_reason = DisconnectReason::Requested;
+            break;
         }
         case PacketId::ConnectedPingPong: {
-            const auto remaining_size = buffer.remaining();
-            auto       send_buffer    = BinaryBuffer(this->company->rent());
-            if (remaining_size == 8) {
-                const auto time = buffer.read_next<packets::ConnectedPing>();
-
-                send_buffer.write(packets::ConnectedPong{
-                    .time_since_start = time.time_since_start,
-                    .time_since_server_start =
-                        detail::time_since_epoch() - this->server_start_time,
-                });
+            if (buffer.remaining() != sizeof(packets::ConnectedPing)) [[unlikely]] {
+                break; // invalid packet
+            }
 
-            } else if (remaining_size == 16) {
-                const auto pong = buffer.read_next<packets::ConnectedPong>();
+            const auto time        = buffer.read_next<packets::ConnectedPing>();
+            auto       memory      = std::array<uint8_t, CONTROL_PACKET_SIZE>{};
+            auto       send_buffer = BinaryBuffer(RentedBuffer(memory, nullptr));
 
-                send_buffer.write(
-                    packets::ConnectedPing{.time_since_start = pong.time_since_start}
-                );
+            send_buffer.write<uint8_t>(std::to_underlying(PacketId::ConnectedPong));
+            send_buffer.write(packets::ConnectedPong{
+                .time_since_start        = time.time_since_start,
+                .time_since_server_start = detail::time_since_epoch() - this->server_start_time,
+            });
 
-            } else [[unlikely]] {
-                // invalid packet
+            // Pings measure latency, sitting in the queue for a tick would skew that
+            this->send_frame(
+                send_buffer, packets::FrameReliability::Unreliable, SendPriority::Immediate
+            );
+            break;
+        }
+        case PacketId::ConnectedPong: {
+            // The answer to send_keepalive. Any packet counts towards the idle timer already,
+            // so all that is left is the round trip, the game never sees these
+            if (buffer.remaining() != sizeof(packets::ConnectedPong)) [[unlikely]] {
+                break;
             }
 
-            this->send_to(this->ready_buffer(send_buffer, packets::FrameReliability::Unreliable)
-            );
+            const auto pong = buffer.read_next<packets::ConnectedPong>();
+            const auto now  = detail::time_since_epoch() - this->server_start_time;
+
+            if (pong.time_since_start <= now) {
+                this->ping_rtt = now - pong.time_since_start;
+            }
+            break;
+        }
+        case PacketId::GameBatch: {
+            if (this->payload.is_enabled()) {
+                this->process_batch(buffer.remaining_slice(), channel);
+                break;
+            }
+            [[fallthrough]];
         }
         default: {
-            if (this->debugger) {
+            if (this->events) {
+                this->deliver_message(body, channel);
+            } else if (this->debugger) {
+                // The debugger always got these without the packet id
                 this->debugger->unhandled_client_packet(
                     buffer.remaining_slice(), this->address
                 );
@@ -185,27 +222,643 @@ namespace rakro {
         }
     }
 
-    std::span<uint8_t> RakroServerClient::ready_buffer(
-        const BinaryBuffer& buffer, packets::FrameReliability rely
+    void RakroServerClient::process_batch(std::span<uint8_t> batch, uint8_t channel) {
+        const auto decoded = this->payload.decode(batch);
+
+        if (!decoded.has_value()) {
+            if (this->debugger) {
+                this->debugger->on_invalid_frame(batch, this->address);
+            }
+            return;
+        }
+
+        for (const auto packet : decoded->packets()) {
+            this->deliver_message(packet, channel);
+        }
+    }
+
+    void RakroServerClient::deliver_message(std::span<uint8_t> payload, uint8_t channel) {
+        if (this->events) {
+            this->events->push(
+                Event{.type = EventType::Message, .client = this->handle(), .channel = channel},
+                payload
+            );
+        } else if (this->debugger) {
+            this->debugger->unhandled_client_packet(payload, this->address);
+        }
+    }
+
+    bool RakroServerClient::process_fragment(BinaryBuffer buffer, packets::FrameInfo info) {
+        auto result =
+            this->fragments.add(info, buffer.remaining_slice(), detail::time_since_epoch());
+
+        if (!result.has_value()) {
+            const auto error = result.error();
+
+            if (this->debugger) {
+                this->debugger->warning_log(std::format(
+                    "Turned away a fragment of split packet {} with {} fragments, error {}",
+                    info.fragment_info->fragment_compound_id, info.fragment_info->fragment_size,
+                    std::to_underlying(error)
+                ));
+            }
+
+            // Its other fragments might be acked already, and resending wont ever get this
+            // one through, so the packet is lost for good
+            if (!is_transient(error)) {
+                this->disconnect_reason = DisconnectReason::Misbehaved;
+            }
+            return false;
+        }
+
+        if (!result->has_value()) {
+            return true; // Still waiting on fragments
+        }
+
+        // Held for ordering, its memory goes along with it rather than being copied again
+        auto& frame = result->value();
+        this->process_frame(
+            BinaryBuffer(RentedBuffer(frame.data(), nullptr)), frame.info, &frame.memory
+        );
+        return true;
+    }
+
+    bool
+    RakroServerClient::can_take(const packets::FrameInfo& info, size_t size) const noexcept {
+        if (!info.order_info.has_value() || info.sequence_frame_index.has_value() ||
+            info.order_info->order_channel >= MAX_ORDER_CHANNELS) {
+            return true;
+        }
+
+        // Fragments are checked with their own size, a reassembled packet is never Full
+        const auto outcome = this->ordering.check(
+            info.order_info->order_channel, info.order_info->order_frame_index,
+            std::max(size, size_t{1})
+        );
+        return outcome != OrderOutcome::TooFarAhead && outcome != OrderOutcome::Full;
+    }
+
+    bool RakroServerClient::send_message(
+        std::span<const uint8_t> packet, packets::FrameReliability rely, SendPriority priority,
+        uint32_t receipt, uint8_t channel, std::vector<uint8_t>& scratch
+    ) {
+        if (!this->payload.is_enabled()) {
+            return this->send_frame(packet, rely, priority, receipt, channel);
+        }
+
+        const std::span<const uint8_t> batched[] = {packet};
+        scratch.resize(this->payload.max_encoded_size(batched));
+
+        auto batch = BinaryBuffer(RentedBuffer(std::span(scratch), nullptr));
+
+        if (!this->payload.encode(batched, batch)) {
+            if (packets::detail::has_ack_receipt(rely)) {
+                this->receipts.on_unreliable(receipt, ReceiptStatus::Lost);
+            }
+            return false;
+        }
+
+        return this->send_frame(batch.consumed_slice(), rely, priority, receipt, channel);
+    }
+
+    bool RakroServerClient::queue_frame(
+        std::span<const uint8_t> body, const SharedBody& shared, packets::FrameReliability rely,
+        SendPriority priority, uint32_t receipt, uint8_t channel
+    ) {
+        const auto receipt_id = packets::detail::has_ack_receipt(rely)
+                                  ? std::optional<uint32_t>(receipt)
+                                  : std::nullopt;
+
+        auto info = packets::FrameInfo{
+            .body_leng = static_cast<uint16_t>(body.size()),
+            .rely      = packets::detail::without_ack_receipt(rely)
+        };
+
+        // Sequenced frames share the order index of the last ordered one on their channel,
+        // like in RakNet
+        channel = static_cast<uint8_t>(channel % MAX_ORDER_CHANNELS);
+
+        // Only sized for now, no index is taken before we know the frame goes out. A skipped
+        // reliable or order index would hold the client's receive window up for good
+        if (packets::detail::is_reliable(info.rely)) {
+            info.reliability_index = uint24_t{};
+        }
+        if (packets::detail::is_seq(info.rely)) {
+            info.sequence_frame_index = uint24_t{};
+        }
+        if (packets::detail::is_ordered(info.rely)) {
+            info.order_info = packets::FrameInfo::OrderInformation{.order_channel = channel};
+        }
+
+        const auto frame_size = BinaryDataInterface<packets::FrameInfo>::size(info) +
+                                body.size() + packets::FRAME_HEADER_SIZE;
+        const auto split      = frame_size > this->max_datagram_size();
+
+        if (split) {
+            const auto piece_size = this->fragment_piece_size(info);
+            const auto count      = (body.size() + piece_size - 1) / piece_size;
+
+            if (count > MAX_FRAGMENT_COUNT) {
+                if (this->debugger) {
+                    this->debugger->warning_log(std::format(
+                        "Refused a {} byte frame, it needs more than {} fragments",
+                        body.size(), MAX_FRAGMENT_COUNT
+                    ));
+                }
+                if (receipt_id.has_value()) {
+                    this->receipts.on_unreliable(*receipt_id, ReceiptStatus::Lost);
+                }
+                return false;
+            }
+        }
+
+        // Fragments take their reliable indexes in send_split
+        if (!split && packets::detail::is_reliable(info.rely)) {
+            info.reliability_index = this->sending_rely_frame_index++;
+        }
+
+        auto& order_index = this->sending_order_index[channel];
+        if (packets::detail::is_seq(info.rely)) {
+            info.sequence_frame_index = this->sending_sequence_index[channel]++;
+        }
+        if (packets::detail::is_ordered(info.rely)) {
+            info.order_info->order_frame_index =
+                packets::detail::is_seq(info.rely) ? order_index : order_index++;
+        }
+
+        if (split) {
+            this->send_split(info, body, shared, priority, receipt_id);
+        } else {
+            // Reliable ones are found again by their index, even once resent
+            auto unreliable_receipt = receipt_id;
+            if (receipt_id.has_value() && info.reliability_index.has_value()) {
+                this->receipts.track_reliable(*info.reliability_index, *receipt_id);
+                unreliable_receipt.reset();
+            }
+
+            if (priority == SendPriority::Immediate) {
+                if (!this->append_frame(info, body, unreliable_receipt)) {
+                    this->requeue_frame(info, body, unreliable_receipt);
+                }
+            } else if (shared != nullptr) {
+                this->frame_queues.push_shared(priority, info, shared, 0, unreliable_receipt);
+            } else {
+                const auto offset = this->frame_queues.store(priority, body);
+                this->frame_queues.push(priority, info, offset, unreliable_receipt);
+            }
+        }
+
+        if (priority == SendPriority::Immediate) {
+            this->flush();
+        }
+        return true;
+    }
+
+    bool RakroServerClient::append_frame(
+        const packets::FrameInfo& info, std::span<const uint8_t> body,
+        std::optional<uint32_t> receipt
+    ) {
+        const auto frame_size =
+            BinaryDataInterface<packets::FrameInfo>::size(info) + body.size();
+
+        if (this->outgoing_frames != 0 && this->outgoing.remaining() < frame_size) {
+            this->flush();
+        }
+
+        if (this->outgoing_frames == 0) {
+            auto rented = this->reserve_outgoing();
+            if (!rented.has_value()) {
+                return false;
+            }
+
+            const auto limit = std::min(this->max_datagram_size(), rented->get_memory().size());
+
+            this->outgoing = BinaryBuffer(std::move(*rented), limit);
+            this->outgoing.skipn(packets::FRAME_HEADER_SIZE); // Written by flush
+        }
+
+        if (this->outgoing.remaining() < frame_size) {
+            // send_frame splits anything this big, so only a bug gets here
+            if (this->debugger) {
+                this->debugger->warning_log(std::format(
+                    "Dropped a {} byte frame, it doesnt fit into a single datagram", frame_size
+                ));
+            }
+            if (receipt.has_value()) {
+                this->receipts.on_unreliable(*receipt, ReceiptStatus::Lost);
+            }
+            return true;
+        }
+
+        this->outgoing.write(info);
+        for (const auto byte : body) {
+            this->outgoing.write_byte(byte);
+        }
+
+        this->outgoing_frames++;
+
+        if (packets::detail::is_reliable(info.rely)) {
+            this->outgoing_reliable = true;
+            this->outgoing_receipts.reliable |=
+                this->receipts.has_reliable() &&
+                this->receipts.is_tracked(*info.reliability_index);
+        } else if (receipt.has_value()) {
+            this->outgoing_receipts.unreliable.push_back(*receipt);
+        }
+        return true;
+    }
+
+    std::optional<RentedBuffer> RakroServerClient::reserve_outgoing() noexcept {
+        const auto held = this->in_flight.size() + this->send_queue.size();
+        if (held >= this->send_buffer_limit) {
+            return std::nullopt;
+        }
+
+        return this->company->try_rent(this->company->get_capacity() / SEND_RESERVE_SHARE);
+    }
+
+    void RakroServerClient::requeue_frame(
+        const packets::FrameInfo& info, std::span<const uint8_t> body,
+        std::optional<uint32_t> receipt
+    ) {
+        const auto offset = this->frame_queues.store(SendPriority::Immediate, body);
+        this->frame_queues.push(SendPriority::Immediate, info, offset, receipt);
+    }
+
+    void RakroServerClient::send_split(
+        packets::FrameInfo info, std::span<const uint8_t> body, const SharedBody& shared,
+        SendPriority priority, std::optional<uint32_t> receipt
+    ) {
+        // A packet is useless with a fragment missing, RakNet upgrades these the same way
+        if (info.rely == packets::FrameReliability::Unreliable) {
+            info.rely = packets::FrameReliability::Reliable;
+        } else if (info.rely == packets::FrameReliability::UnreliableSequenced) {
+            info.rely = packets::FrameReliability::ReliableSequenced;
+        }
+
+        // queue_frame already made sure this is at most MAX_FRAGMENT_COUNT
+        const auto piece_size = this->fragment_piece_size(info);
+        const auto count      = (body.size() + piece_size - 1) / piece_size;
+
+        // Every fragment shares the order info, but gets its own reliable index
+        const auto compound_id = this->split_compound_id++;
+
+        // Queued fragments all point into one copy of the body, or the shared one. Immediate
+        // ones are only queued once they run out of buffers
+        auto stored = std::optional<size_t>();
+        if (priority != SendPriority::Immediate && shared == nullptr) {
+            stored = this->frame_queues.store(priority, body);
+        }
+
+        for (size_t index = 0; index < count; index++) {
+            const auto offset = index * piece_size;
+            const auto piece =
+                body.subspan(offset, std::min(piece_size, body.size() - offset));
+
+            info.body_leng         = static_cast<uint16_t>(piece.size());
+            info.reliability_index = this->sending_rely_frame_index++;
+            info.fragment_info     = packets::FrameInfo::FragmentInformation{
+                    .fragment_size        = static_cast<uint32_t>(count),
+                    .fragment_compound_id = compound_id,
+                    .fragment_index       = static_cast<uint32_t>(index)
+            };
+
+            // Acked once every fragment is
+            if (receipt.has_value()) {
+                this->receipts.track_reliable(*info.reliability_index, *receipt);
+            }
+
+            if (priority == SendPriority::Immediate && !stored.has_value() &&
+                this->append_frame(info, piece)) {
+                continue;
+            }
+
+            if (shared != nullptr) {
+                this->frame_queues.push_shared(priority, info, shared, offset);
+            } else {
+                if (!stored.has_value()) {
+                    stored = this->frame_queues.store(priority, body);
+                }
+                this->frame_queues.push(priority, info, *stored + offset);
+            }
+        }
+    }
+
+    size_t RakroServerClient::fragment_piece_size(packets::FrameInfo info) const noexcept {
+        info.reliability_index = uint24_t{};
+        info.fragment_info     = packets::FrameInfo::FragmentInformation{};
+
+        const auto overhead =
+            packets::FRAME_HEADER_SIZE + BinaryDataInterface<packets::FrameInfo>::size(info);
+        return this->max_datagram_size() - overhead;
+    }
+
+    void RakroServerClient::update(uint64_t now) {
+        this->in_flight_scratch.clear();
+
+        while (!this->retransmit_timers.empty()) {
+            const auto timer = this->retransmit_timers.top();
+            if (timer.deadline > now) {
+                break;
+            }
+            this->retransmit_timers.pop();
+
+            // Acked already, or resent and rescheduled since
+            const auto* sent = this->in_flight.find(timer.sequence);
+            if (sent == nullptr || sent->deadline != timer.deadline) {
+                continue;
+            }
+
+            this->in_flight_scratch.push_back(timer.sequence);
+        }
+
+        // Resent only once the heap is drained, so the new timers cant come up this tick
+        if (!this->in_flight_scratch.empty()) {
+            // Back off once per tick, not once per datagram, a burst of losses would
+            // otherwise throw the RTO straight to the max
+            this->rtt.on_timeout();
+            this->congestion->on_timeout(now);
+            this->update_pacing_rate();
+
+            for (const auto sequence : this->in_flight_scratch) {
+                this->resend(sequence);
+            }
+        }
+
+        this->send_acknowledgements();
+        this->flush();
+        this->acks_sent_this_tick = false;
+
+        if (this->debugger && (this->bytes_in_flight != 0 || !this->send_queue.empty() ||
+                               !this->frame_queues.empty())) {
+            this->debugger->on_congestion_stats(this->get_congestion_stats(), this->address);
+        }
+
+        this->fragments.expire(now);
+
+        this->deliver_receipts();
+    }
+
+    void RakroServerClient::abandon_receipts() {
+        this->receipts.lose_reliable();
+
+        // Unreliable receipts travel with their frame, then with the datagram it went into
+        const auto lose = [&](uint32_t receipt) {
+            this->receipts.on_unreliable(receipt, ReceiptStatus::Lost);
+        };
+        const auto lose_all = [&](const DatagramReceipts& held) {
+            std::ranges::for_each(held.unreliable, lose);
+        };
+
+        this->frame_queues.for_each_receipt(lose);
+        lose_all(this->outgoing_receipts);
+        for (const auto& queued : this->send_queue) {
+            lose_all(queued.receipts);
+        }
+        this->in_flight.for_each([&](const SentDatagram& sent) { lose_all(sent.receipts); });
+
+        this->deliver_receipts();
+    }
+
+    void RakroServerClient::deliver_receipts() {
+        if (this->receipts.get_events().empty()) {
+            return;
+        }
+
+        if (this->debugger) {
+            this->debugger->on_receipts(this->receipts.get_events(), this->address);
+        }
+        if (this->events) {
+            for (const auto receipt : this->receipts.get_events()) {
+                this->events->push(Event{
+                    .type = EventType::Receipt, .client = this->handle(), .receipt = receipt
+                });
+            }
+        }
+        this->receipts.clear_events();
+    }
+
+    void RakroServerClient::send_acknowledgements() {
+        if (this->acks_sent_this_tick) {
+            return;
+        }
+
+        // Whatever turned up since it was found missing doesnt need a resend anymore
+        this->nack_scratch.clear();
+        for (const auto range : this->pending_nacks) {
+            this->received.collect_missing(range, this->nack_scratch);
+        }
+        std::swap(this->pending_nacks, this->nack_scratch);
+
+        this->acks_sent_this_tick = true;
+        this->send_ack_records(PacketId::Ack, this->pending_acks);
+        this->send_ack_records(PacketId::Nack, this->pending_nacks);
+    }
+
+    void RakroServerClient::send_ack_records(
+        PacketId id, std::vector<packets::SequenceRange>& pending
     ) {
+        if (pending.empty()) {
+            return;
+        }
+
+        // Ranges only overlap or touch when datagrams arrived out of order, merge those
+        std::ranges::sort(pending, [](packets::SequenceRange lhs, packets::SequenceRange rhs) {
+            return sequence_delta(lhs.start, rhs.start) < 0;
+        });
+
+        size_t merged = 0;
+        for (size_t index = 1; index < pending.size(); index++) {
+            auto&      last  = pending[merged];
+            const auto range = pending[index];
+
+            if (sequence_delta(range.start, last.end) <= 1) {
+                if (sequence_delta(range.end, last.end) > 0) {
+                    last.end = range.end;
+                }
+            } else {
+                pending[++merged] = range;
+            }
+        }
+        pending.resize(merged + 1);
+
+        // One datagram per tick at most, anything that doesnt fit waits for the next one, as
+        // does everything if the pool is dry
+        auto rented = this->company->try_rent();
+        if (!rented.has_value()) {
+            return;
+        }
+
+        const auto limit  = std::min(this->max_datagram_size(), rented->get_memory().size());
+        auto       buffer = BinaryBuffer(std::move(*rented), limit);
+
+        const auto written = packets::write_ack_records(id, pending, buffer);
+
+        this->send_to(buffer.consumed_slice());
+        pending.erase(pending.begin(), pending.begin() + static_cast<ptrdiff_t>(written));
+    }
+
+    void RakroServerClient::flush() {
+        this->seal_outgoing();
+        this->drain_send_queue(detail::time_since_epoch());
+    }
+
+    void RakroServerClient::seal_outgoing() {
+        if (this->outgoing_frames == 0) {
+            return;
+        }
+
+        this->send_queue.push_back(
+            {.datagram = std::move(this->outgoing),
+             .reliable = this->outgoing_reliable,
+             .receipts = std::move(this->outgoing_receipts)}
+        );
+
+        this->outgoing          = BinaryBuffer();
+        this->outgoing_frames   = 0;
+        this->outgoing_reliable = false;
+        this->outgoing_receipts = DatagramReceipts();
+    }
+
+    void RakroServerClient::drain_send_queue(uint64_t now) {
+        while (!this->send_queue.empty() || !this->frame_queues.empty()) {
+            // Queued frames arent packed yet, so any room left in the window will do
+            const auto size = this->send_queue.empty()
+                                ? size_t{1}
+                                : this->send_queue.front().datagram.consumed();
 
-        auto send_buffer = BinaryBuffer(this->company->rent());
-        send_buffer.write(this->make_header());
+            // An empty pipe always takes one, a datagram bigger than the whole window would
+            // stall the connection otherwise
+            if (this->bytes_in_flight != 0 &&
+                this->bytes_in_flight + size > this->congestion->get_window()) {
+                break;
+            }
+
+            if (!this->in_flight.has_room(this->send_sequence) || !this->pacer.can_send(now)) {
+                break;
+            }
 
-        send_buffer.write(packets::make_info(rely, buffer));
+            // Packed only now, so whatever got queued with a higher priority while the
+            // window was full still makes it into this datagram
+            if (this->send_queue.empty() && !this->pack_queued_frames()) {
+                break;
+            }
 
-        for (const auto byte : buffer.consumed_slice()) {
-            send_buffer.write_byte(byte);
+            this->transmit(this->send_queue.front(), now);
+            this->send_queue.pop_front();
         }
+    }
 
-        const auto out_buff = send_buffer.consumed_slice();
+    bool RakroServerClient::pack_queued_frames() {
+        while (const auto frame = this->frame_queues.peek()) {
+            const auto& info = *frame->info;
+            const auto  frame_size =
+                BinaryDataInterface<packets::FrameInfo>::size(info) + frame->body.size();
 
-        if (packets::detail::is_reliable(rely)) {
-            const auto index = this->sending_rely_frame_index++;
-            this->ack_buffer.insert({index, std::move(send_buffer)});
+            if (this->outgoing_frames != 0 && this->outgoing.remaining() < frame_size) {
+                break;
+            }
+
+            if (!this->append_frame(info, frame->body, frame->receipt)) {
+                break; // Stays queued until a buffer frees up
+            }
+            this->frame_queues.pop();
         }
 
-        return out_buff;
+        this->seal_outgoing();
+        return !this->send_queue.empty();
+    }
+
+    void RakroServerClient::transmit(QueuedDatagram& queued, uint64_t now) {
+        auto& datagram = queued.datagram;
+
+        const auto sequence = this->send_sequence++;
+        const auto end      = datagram.consumed();
+
+        datagram.go_to(0);
+        datagram.write(packets::FrameHeader{.sequence_number = sequence});
+        datagram.go_to(end);
+
+        this->send_to(datagram.consumed_slice());
+        this->pacer.on_send(end);
+
+        // Acks ride along with whatever we send first in a tick, the tick only sends them if
+        // nothing went out before it
+        this->send_acknowledgements();
+
+        // Unreliable frames with a receipt are tracked too, just never resent
+        if (queued.reliable || !queued.receipts.empty()) {
+            const auto deadline = now + this->rtt.get_rto();
+
+            this->bytes_in_flight += end;
+            this->in_flight.insert(
+                sequence, SentDatagram{
+                              .datagram = std::move(datagram),
+                              .sent_at  = now,
+                              .deadline = deadline,
+                              .receipts = std::move(queued.receipts)
+                          }
+            );
+            this->retransmit_timers.push({.deadline = deadline, .sequence = sequence});
+        }
+    }
+
+    void RakroServerClient::update_pacing_rate() noexcept {
+        if (!this->rtt.has_samples()) {
+            this->pacer.set_rate(0); // Nothing to spread it over yet
+            return;
+        }
+
+        const auto gain = this->congestion->in_slow_start() ? SLOW_START_PACING_GAIN
+                                                             : PACING_GAIN;
+        const auto srtt = std::max(this->rtt.get_srtt(), uint64_t{1});
+
+        this->pacer.set_rate(this->congestion->get_window() * gain * 1000 / (100 * srtt));
+    }
+
+    std::optional<uint64_t> RakroServerClient::next_service(uint64_t now) const noexcept {
+        // acks_sent_this_tick is only cleared by update, acks arriving after it is set would
+        // otherwise sit there
+        if (!this->pending_acks.empty() || !this->pending_nacks.empty() ||
+            this->acks_sent_this_tick || this->outgoing_frames != 0 ||
+            !this->send_queue.empty() || !this->frame_queues.empty() ||
+            !this->receipts.get_events().empty() || this->fragments.get_pending() != 0) {
+            return now;
+        }
+
+        // Might be a datagram that was acked since, that only costs an early update
+        if (!this->retransmit_timers.empty()) {
+            return this->retransmit_timers.top().deadline;
+        }
+
+        return std::nullopt;
+    }
+
+    void RakroServerClient::send_keepalive(uint64_t now) {
+        auto memory      = std::array<uint8_t, CONTROL_PACKET_SIZE>{};
+        auto send_buffer = BinaryBuffer(RentedBuffer(memory, nullptr));
+
+        send_buffer.write<uint8_t>(std::to_underlying(PacketId::ConnectedPingPong));
+        send_buffer.write(
+            packets::ConnectedPing{.time_since_start = now - this->server_start_time}
+        );
+
+        this->send_frame(
+            send_buffer, packets::FrameReliability::Unreliable, SendPriority::Immediate
+        );
+        this->keepalive_sent = now;
+    }
+
+    CongestionStats RakroServerClient::get_congestion_stats() const noexcept {
+        return CongestionStats{
+            .window        = this->congestion ? this->congestion->get_window() : 0,
+            .in_flight     = this->bytes_in_flight,
+            .pacing_rate   = this->pacer.get_rate(),
+            .srtt          = this->rtt.get_srtt(),
+            .rto           = this->rtt.get_rto(),
+            .queued        = this->send_queue.size(),
+            .queued_frames = this->frame_queues.size(),
+        };
     }
 
     void RakroServerClient::send_to(std::span<uint8_t> buffer) {
@@ -217,10 +870,124 @@ namespace rakro {
     }
 
     void RakroServerClient::process_ack(BinaryBuffer buffer) {
-        const auto ack = buffer.read_next<packets::Ack>();
+        const auto ack = packets::Ack::from_bytes(buffer.remaining_slice());
+
+        if (!ack.has_value()) {
+            if (this->debugger) {
+                this->debugger->on_invalid_frame(buffer.remaining_slice(), this->address);
+            }
+            return;
+        }
+
+        // Only the newest datagram is sampled, the older ones in the same ack mostly measure
+        // how long the client sat on it
+        uint64_t newest_send = 0;
+        size_t   acked_bytes = 0;
+        for (const auto range : ack->records) {
+            this->in_flight.take_range(range, [&](uint24_t, SentDatagram&& sent) {
+                newest_send = std::max(newest_send, sent.sent_at);
+                acked_bytes += sent.datagram.consumed();
+
+                if (!sent.receipts.empty()) {
+                    this->ack_receipts(sent);
+                }
+            });
+        }
+
+        if (acked_bytes == 0) {
+            return;
+        }
+        this->bytes_in_flight -= acked_bytes;
+
+        const auto now = detail::time_since_epoch();
+        this->rtt.on_sample(now > newest_send ? now - newest_send : 0);
+
+        this->congestion->on_ack(now, acked_bytes, this->rtt.get_srtt());
+        this->update_pacing_rate();
+
+        // The window just opened up, dont leave whatever is queued waiting for the tick
+        this->drain_send_queue(now);
+    }
+
+    void RakroServerClient::process_nack(BinaryBuffer buffer) {
+        const auto nack = packets::Nack::from_bytes(buffer.remaining_slice());
+
+        if (!nack.has_value()) {
+            if (this->debugger) {
+                this->debugger->on_invalid_frame(buffer.remaining_slice(), this->address);
+            }
+            return;
+        }
+
+        // Collected first, resending puts new datagrams into the window
+        this->in_flight_scratch.clear();
+        for (const auto range : nack->records) {
+            this->in_flight.collect(range, this->in_flight_scratch);
+        }
+
+        if (this->in_flight_scratch.empty()) {
+            return;
+        }
+
+        // The client told us exactly what is gone, no point waiting for the timers
+        for (const auto sequence : this->in_flight_scratch) {
+            this->resend(sequence);
+        }
+
+        this->congestion->on_loss(detail::time_since_epoch(), this->rtt.get_srtt());
+        this->update_pacing_rate();
+        this->flush();
+    }
+
+    void RakroServerClient::ack_receipts(SentDatagram& sent) {
+        for (const auto receipt : sent.receipts.unreliable) {
+            this->receipts.on_unreliable(receipt, ReceiptStatus::Acked);
+        }
+
+        if (!sent.receipts.reliable) {
+            return;
+        }
+
+        auto frames = BinaryBuffer(RentedBuffer(sent.datagram.consumed_slice(), nullptr));
+        frames.skipn(packets::FRAME_HEADER_SIZE);
+
+        while (frames.remaining() != 0) {
+            const auto info = packets::read_frame_info(frames);
+            frames.skipn(info.body_leng);
 
-        for (const auto id : ack.all_packets()) {
-            this->ack_buffer.erase(id);
+            if (info.reliability_index.has_value()) {
+                this->receipts.on_reliable_acked(*info.reliability_index);
+            }
+        }
+    }
+
+    void RakroServerClient::resend(uint24_t sequence) {
+        auto sent = this->in_flight.take(sequence);
+
+        if (!sent.has_value()) {
+            return;
+        }
+
+        // Out of flight as far as the window goes, the frames count again once resent
+        this->bytes_in_flight -= sent->datagram.consumed();
+
+        for (const auto receipt : sent->receipts.unreliable) {
+            this->receipts.on_unreliable(receipt, ReceiptStatus::Lost);
+        }
+
+        auto frames = BinaryBuffer(RentedBuffer(sent->datagram.consumed_slice(), nullptr));
+        frames.skipn(packets::FRAME_HEADER_SIZE);
+
+        // Unreliable frames that rode along are not worth sending again, the reliable ones
+        // keep their reliable index so the client can tell them apart from new ones
+        while (frames.remaining() != 0) {
+            const auto info = packets::read_frame_info(frames);
+            const auto body = frames.remaining_slice().subspan(0, info.body_leng);
+            frames.skipn(info.body_leng);
+
+            if (packets::detail::is_reliable(info.rely) && !this->append_frame(info, body)) {
+                this->requeue_frame(info, body, std::nullopt);
+            }
         }
     }
 
@@ -237,7 +1004,7 @@ namespace rakro {
         if (data > packets::VALID_MAX_FRAME_ID) {
             switch (static_cast<PacketId>(data)) {
             case PacketId::Nack: {
-                std::println("Unhandled NACK");
+                this->process_nack(std::move(packet_data));
                 break;
             }
             case PacketId::Ack: {
@@ -250,22 +1017,43 @@ namespace rakro {
         }
 
         const auto frame_header = packet_data.read_next<packets::FrameHeader>();
+        const auto sequence     = frame_header.sequence_number;
+        const auto expected     = this->received.get_next();
 
-        if (frame_header.sequence_number < this->next_expected_seq) return;
-        else if (frame_header.sequence_number > this->next_expected_seq) {
-            for (uint24_t current_seq = this->next_expected_seq + 1;
-                 current_seq < frame_header.sequence_number; current_seq++) {
-                this->missing_packets.insert(current_seq.get_value());
+        switch (this->received.receive(sequence)) {
+        case Arrival::New: {
+            if (sequence != expected) {
+                this->pending_nacks.push_back({.start = expected, .end = sequence - 1});
             }
+            break;
+        }
+        case Arrival::Late: {
+            break;
+        }
+        case Arrival::Duplicate: {
+            // Acked again since the client evidently didnt see the first ack, but there is
+            // nothing left to process
+            this->push_ack(sequence);
+            this->duplicates.datagrams++;
+            return;
+        }
+        case Arrival::TooFarAhead: {
+            if (this->debugger) {
+                this->debugger->on_invalid_frame(packet_data.underlying(), this->address);
+            }
+            return; // Nothing legit skips that far ahead
+        }
         }
 
-        this->next_expected_seq++;
+        // Only acked once every reliable frame in it was taken, the client resends whatever we
+        // turned away instead of us dropping it after the ack
+        bool rejected = false;
 
         // 4 Is the minimum packet viable
         // 3 for its header
         // and a 1 byte payload
         while (packet_data.remaining() > 4) {
-            const auto header            = packet_data.read_next<packets::FrameInfo>();
+            const auto header            = packets::read_frame_info(packet_data);
             const auto next_packet_slice = packet_data.remaining_slice();
 
             auto buffer =
@@ -273,11 +1061,221 @@ namespace rakro {
 
             packet_data.skipn(header.body_leng);
 
+            // Fragments each have their own index, so this happens before reassembly
+            if (header.reliability_index.has_value()) {
+                const auto arrival = this->received_reliable.check(*header.reliability_index);
+
+                if (arrival == Arrival::Duplicate) {
+                    this->duplicates.frames++;
+                    continue;
+                }
+
+                // Past what the window can track, it is resent once the window moved up
+                if (arrival == Arrival::TooFarAhead) {
+                    if (this->debugger) {
+                        this->debugger->on_invalid_frame(
+                            buffer.remaining_slice(), this->address
+                        );
+                    }
+                    rejected = true;
+                    continue;
+                }
+
+                if (!this->can_take(header, buffer.remaining())) {
+                    rejected = true;
+                    continue;
+                }
+            }
+
+            // The index is only marked once the frame was taken, the assembler can still turn
+            // a fragment away
             if (header.fragment_info.has_value()) {
-                std::println("Unhandled frame type, fragment!");
+                if (!this->process_fragment(std::move(buffer), header)) {
+                    rejected = true;
+                    continue;
+                }
             } else {
-                this->process_frame(std::move(buffer), std::move(header));
+                this->process_frame(std::move(buffer), header);
             }
+
+            if (header.reliability_index.has_value()) {
+                this->received_reliable.receive(*header.reliability_index);
+            }
+        }
+
+        if (!rejected) {
+            this->push_ack(sequence);
         }
     }
+
+    void ClientRouter::update(uint64_t now) {
+        this->events.flush();
+        this->drain_outbox(now);
+
+        // Service first, an idle timer can drop a client whose acks are due this tick
+        this->service_timers.advance(
+            now, std::numeric_limits<size_t>::max(),
+            [&](detail::IPV4Addr address) {
+                auto* client = this->connected_clients.find(address);
+                if (client != nullptr) {
+                    this->on_service(address, *client, now);
+                }
+            }
+        );
+
+        this->idle_timers.advance(
+            now, MAX_IDLE_EXPIRIES_PER_TICK,
+            [&](detail::IPV4Addr address) {
+                auto* client = this->connected_clients.find(address);
+                if (client != nullptr) {
+                    this->on_idle(address, *client, now);
+                }
+            }
+        );
+    }
+
+    void ClientRouter::drain_outbox(uint64_t now) {
+        this->outbox.drain(MAX_SENDS_PER_TICK, [&](const QueuedSend& send) {
+            if (send.shared != nullptr) {
+                this->send_broadcast(send, now);
+                return;
+            }
+
+            auto* client = this->connected_clients.find(send.client.address);
+
+            // Gone, or someone else has the address now. Disconnected already told the game
+            if (client == nullptr || client->guid != send.client.guid) {
+                return;
+            }
+
+            if (send.settings.has_value()) {
+                client->update_payload_settings(*send.settings);
+                return;
+            }
+
+            client->send_message(
+                send.payload, send.rely, send.priority, send.receipt, send.channel,
+                this->encoded
+            );
+            this->schedule_service(send.client.address, *client, now, false);
+        });
+    }
+
+    void ClientRouter::send_broadcast(const QueuedSend& send, uint64_t now) {
+        const auto deliver = [&](RakroServerClient& client) {
+            const auto body = this->broadcast_body(send.shared, client);
+            if (body != nullptr) {
+                client.send_frame(body, send.rely, send.priority, 0, send.channel);
+                this->schedule_service(client.address, client, now, false);
+            }
+        };
+
+        // Every queued frame holds its own reference, the next broadcast starts over
+        this->batched_bodies.clear();
+
+        if (!send.everyone) {
+            for (const auto& recipient : send.recipients) {
+                auto* client = this->connected_clients.find(recipient.address);
+                if (client != nullptr && client->guid == recipient.guid) {
+                    deliver(*client);
+                }
+            }
+            return;
+        }
+
+        this->excluded.clear();
+        for (const auto& recipient : send.recipients) {
+            this->excluded.push_back(recipient.address.packed());
+        }
+        std::ranges::sort(this->excluded);
+
+        // Only the ones the game was told about, the rest are still connecting
+        this->connected_clients.for_each([&](RakroServerClient& client) {
+            if (client.announced &&
+                !std::ranges::binary_search(this->excluded, client.address.packed())) {
+                deliver(client);
+            }
+        });
+    }
+
+    SharedBody
+    ClientRouter::broadcast_body(const SharedBody& packet, RakroServerClient& client) {
+        if (!client.payload.is_enabled()) {
+            return packet;
+        }
+
+        const auto& settings = client.payload.get_settings();
+        for (const auto& [batched_with, body] : this->batched_bodies) {
+            if (batched_with == settings) {
+                return body;
+            }
+        }
+
+        const std::span<const uint8_t> batched[] = {*packet};
+        auto encoded = std::vector<uint8_t>(client.payload.max_encoded_size(batched));
+        auto batch   = BinaryBuffer(RentedBuffer(std::span(encoded), nullptr));
+
+        if (!client.payload.encode(batched, batch)) {
+            return nullptr;
+        }
+
+        encoded.resize(batch.consumed());
+        auto body = std::make_shared<const std::vector<uint8_t>>(std::move(encoded));
+
+        this->batched_bodies.emplace_back(settings, body);
+        return body;
+    }
+
+    void
+    ClientRouter::on_idle(detail::IPV4Addr address, RakroServerClient& client, uint64_t now) {
+        const auto silent = now - std::min(now, client.last_packet);
+
+        if (silent > this->timeout) {
+            this->disconnect(address, client, DisconnectReason::TimedOut);
+            return;
+        }
+
+        // Once per quiet stretch, anything the client sends starts a new one
+        if (silent >= this->keepalive_after && client.keepalive_sent < client.last_packet) {
+            client.send_keepalive(now);
+            this->schedule_service(address, client, now, false);
+        }
+
+        const auto deadline = silent >= this->keepalive_after
+                                  ? client.last_packet + this->timeout + 1
+                                  : client.last_packet + this->keepalive_after;
+
+        client.idle_timer = this->idle_timers.arm(deadline, address);
+    }
+
+    void ClientRouter::on_service(
+        detail::IPV4Addr address, RakroServerClient& client, uint64_t now
+    ) {
+        client.update(now);
+        this->schedule_service(address, client, now, true);
+    }
+
+    void ClientRouter::schedule_service(
+        detail::IPV4Addr address, RakroServerClient& client, uint64_t now, bool reset
+    ) {
+        const auto next = client.next_service(now);
+
+        if (!next.has_value()) {
+            if (reset) {
+                this->service_timers.cancel(client.service_timer);
+            }
+            return;
+        }
+
+        // Never the tick being handled right now, that would fire it again straight away
+        const auto deadline = std::max(*next, now + SERVICE_RESOLUTION_MS);
+
+        if (!reset && this->service_timers.is_live(client.service_timer) &&
+            client.service_at <= deadline) {
+            return;
+        }
+
+        client.service_at = deadline;
+        this->service_timers.rearm(client.service_timer, deadline, address);
+    }
 } // namespace rakro
\ No newline at end of file
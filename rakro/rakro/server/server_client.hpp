@@ -1,26 +1,54 @@
 #pragma once
 
+#include "rakro/internal/address_table.hpp"
 #include "rakro/internal/binary_buffer.hpp"
 #include "rakro/internal/buffer_company.hpp"
 #include "rakro/internal/net.hpp"
+#include "rakro/internal/timer_wheel.hpp"
 #include "rakro/packet/frame_set.hpp"
+#include "rakro/packet/ack_records.hpp"
+#include "rakro/server/congestion.hpp"
 #include "rakro/server/debug_instrument.hpp"
+#include "rakro/server/events.hpp"
+#include "rakro/server/fragments.hpp"
+#include "rakro/server/outbox.hpp"
+#include "rakro/server/payload_pipeline.hpp"
+#include "rakro/server/reorder.hpp"
+#include "rakro/server/retransmit.hpp"
+#include "rakro/server/send_priority.hpp"
+#include "rakro/server/sequence_window.hpp"
+#include <algorithm>
 #include <cstdint>
-#include <rakro/internal/strong_typed_int_hash.hpp>
-#include <unordered_map>
-#include <unordered_set>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
 
 namespace rakro {
 
-    using OrderKey                      = BaseStrongType<uint32_t>;
-    constexpr size_t MAX_ORDER_CHANNELS = 32;
-
-    inline OrderKey construct_order_key(uint8_t order_channel, uint24_t order_index) noexcept {
-        uint32_t base = static_cast<uint32_t>(order_channel)
-                        << 27; // Clips the order channel to 5 bits
-        base |= order_index.get_value();
-
-        return OrderKey(base);
+    // IP (20) + UDP (8), the MTU a client negotiates includes both
+    constexpr size_t UDP_HEADER_OVERHEAD = 28;
+
+    // Fired idle timers a router handles per tick. Whatever is left over waits for the next
+    // tick, so a mass disconnect cant hold up ingress. Service timers have a wheel of their
+    // own and no budget, acks and resends cant wait behind a wave of keepalives
+    constexpr size_t MAX_IDLE_EXPIRIES_PER_TICK = 1024;
+    // Tick of the connection timers, a service timer is never due sooner than one tick out
+    constexpr uint64_t SERVICE_RESOLUTION_MS = 10;
+
+    // Part of the pool the send path never rents, 1 / SEND_RESERVE_SHARE of it. The listener
+    // needs buffers for the acks that free up everything else
+    constexpr size_t SEND_RESERVE_SHARE = 4;
+    // No client holds more than 1 / CLIENT_SEND_SHARE of the pool in datagrams that are
+    // queued or waiting on an ack, its congestion window is capped to match
+    constexpr size_t CLIENT_SEND_SHARE       = 16;
+    constexpr size_t MIN_CLIENT_SEND_BUFFERS = 8;
+
+    inline size_t client_send_buffers(const BufferCompany* company) noexcept {
+        const auto share = company ? company->get_capacity() / CLIENT_SEND_SHARE : 0;
+        return std::clamp(share, MIN_CLIENT_SEND_BUFFERS, size_t{MAX_IN_FLIGHT});
     }
 
     struct SemiConnectedClient {
@@ -28,53 +56,206 @@ namespace rakro {
         uint16_t mtu{};
     };
 
-    // TODO: Make this run on multiple threads using a threadpool interface
+    // A finished frame set waiting for the congestion window, its header is written once it
+    // actually goes out
+    struct QueuedDatagram {
+        BinaryBuffer     datagram{};
+        bool             reliable{false};
+        DatagramReceipts receipts{};
+    };
 
+    // Not thread safe, a client only ever runs on the thread of the router that owns it, see
+    // ShardedRouter
     class RakroServerClient {
-    public:
-        struct PacketInformation {
-            BinaryBuffer       raw_data{};
-            packets::FrameInfo packet_info{};
-            PacketInformation(BinaryBuffer&& buffer, packets::FrameInfo&& info)
-                : raw_data(std::forward<BinaryBuffer>(buffer)),
-                  packet_info(std::forward<packets::FrameInfo>(info)) {}
-            PacketInformation()                    = default;
-            PacketInformation(PacketInformation&&) = default;
-        };
-
     public:
         RakroServerClient() = default;
         RakroServerClient(
             uint64_t guid, IRakServerDebugInstrument* debugger, detail::UdpSocket* socket,
             uint16_t mtu, BufferCompany* company, detail::IPV4Addr address,
-            uint64_t server_start_time
+            uint64_t server_start_time, CodecPool* codecs, PayloadSettings payload_settings,
+            CongestionAlgorithm congestion_algorithm, ScratchPool* scratch
         )
             : guid(guid), debugger(debugger), socket(socket), company(company), mtu(mtu),
-              address(address), server_start_time(server_start_time) {}
-        RakroServerClient(RakroServerClient&&)      = default;
-        RakroServerClient(const RakroServerClient&) = delete;
+              address(address), server_start_time(server_start_time),
+              payload(codecs, payload_settings),
+              send_buffer_limit(client_send_buffers(company)),
+              congestion(make_congestion_control(
+                  congestion_algorithm, max_datagram_size(),
+                  client_send_buffers(company) * max_datagram_size()
+              )),
+              fragments(scratch, max_datagram_size() - packets::FRAME_HEADER_SIZE),
+              ordering(scratch) {}
+        RakroServerClient(RakroServerClient&&)            = default;
+        RakroServerClient& operator=(RakroServerClient&&) = default;
+        RakroServerClient(const RakroServerClient&)       = delete;
 
         void process_packet(BinaryBuffer buffer);
 
         uint64_t get_guid() const noexcept { return this->guid; }
 
+        // Flip compression on once the game has negotiated it
+        void update_payload_settings(PayloadSettings settings) noexcept {
+            this->payload.update_settings(settings);
+        }
+
+        // Queues a frame by priority, queued frames are only packed into datagrams once the
+        // congestion window and the pacer let one out. Immediate frames skip the queues and
+        // are sent straight away, ahead of anything queued. Bodies too big for one datagram
+        // are split, which makes unreliable ones reliable.
+        //
+        // The WithAckReceipt reliabilities report receipt as acked or lost on a later tick,
+        // see IRakServerDebugInstrument::on_receipts. Ordered and sequenced frames go out on
+        // channel, modulo MAX_ORDER_CHANNELS.
+        //
+        // False if the body would need more than MAX_FRAGMENT_COUNT fragments, nothing is sent
+        // then and its receipt is reported lost
+        bool send_frame(
+            std::span<const uint8_t> body, packets::FrameReliability rely,
+            SendPriority priority, uint32_t receipt = 0, uint8_t channel = 0
+        ) {
+            return this->queue_frame(body, nullptr, rely, priority, receipt, channel);
+        }
+        // Queued frames keep a reference to body instead of copying it
+        bool send_frame(
+            const SharedBody& body, packets::FrameReliability rely, SendPriority priority,
+            uint32_t receipt = 0, uint8_t channel = 0
+        ) {
+            return this->queue_frame(*body, body, rely, priority, receipt, channel);
+        }
+        bool send_frame(
+            const BinaryBuffer& body, packets::FrameReliability rely, SendPriority priority,
+            uint32_t receipt = 0
+        ) {
+            return this->send_frame(body.consumed_slice(), rely, priority, receipt);
+        }
+
+        // A game packet rather than a raw frame body. With the pipeline on it is sent as a
+        // batch of one, compressed once it passes the threshold, and built in scratch first
+        bool send_message(
+            std::span<const uint8_t> packet, packets::FrameReliability rely,
+            SendPriority priority, uint32_t receipt, uint8_t channel,
+            std::vector<uint8_t>& scratch
+        );
+
+        // Closes the datagram being built and sends as much as the congestion window and the
+        // pacer allow, along with the acks and nacks if they havent gone out this tick yet
+        void flush();
+
+        // Called by the router once next_service comes up, resends whatever timed out
+        void update(uint64_t now);
+
+        // When update next has something to do, now if anything is waiting to go out,
+        // otherwise the earliest retransmit deadline. nullopt if the client is idle
+        std::optional<uint64_t> next_service(uint64_t now) const noexcept;
+
+        // Unreliable ConnectedPing, so a quiet client has something to answer
+        void send_keepalive(uint64_t now);
+
+        // Called by the router as the client is dropped, reports every receipt that is still
+        // waiting on an ack as lost, right away. Reliable ones, and unreliable ones whose frame
+        // is queued or in flight
+        void abandon_receipts();
+
+        CongestionStats get_congestion_stats() const noexcept;
+
+        // Round trip of the last keepalive the client answered in ms, 0 until one was
+        uint64_t get_ping_rtt() const noexcept { return this->ping_rtt; }
+
+        DuplicateStats get_duplicate_stats() const noexcept { return this->duplicates; }
+
+        ClientHandle handle() const noexcept {
+            return ClientHandle{.address = this->address, .guid = this->guid};
+        }
+
     private:
-        void process_frame(BinaryBuffer buffer, packets::FrameInfo info);
-        void process_data(BinaryBuffer buffer);
+        // owned is where buffer lives if it isnt a datagram, see OrderingChannels::receive
+        void process_frame(
+            BinaryBuffer buffer, packets::FrameInfo info, RentedScratch* owned = nullptr
+        );
+        // channel is the ordering channel the frame came in on, 0 if it wasnt ordered
+        void process_data(BinaryBuffer buffer, uint8_t channel = 0);
+        void process_batch(std::span<uint8_t> batch, uint8_t channel);
+        // Hands a game packet to the event channel, or the debugger if there is none
+        void deliver_message(std::span<uint8_t> payload, uint8_t channel);
+        // False if the assembler turned the fragment away, see can_take
+        bool process_fragment(BinaryBuffer buffer, packets::FrameInfo info);
+        // False if a reliable frame would be dropped after being taken, it is turned away
+        // before its index is marked then, and the datagram isnt acked
+        bool can_take(const packets::FrameInfo& info, size_t size) const noexcept;
 
         void send_to(std::span<uint8_t> buffer);
 
-        void process_ack(BinaryBuffer buffer);
+        // shared is null unless body is the whole of it
+        bool queue_frame(
+            std::span<const uint8_t> body, const SharedBody& shared,
+            packets::FrameReliability rely, SendPriority priority, uint32_t receipt,
+            uint8_t channel
+        );
+
+        // Moves the datagram being built onto the send queue
+        void seal_outgoing();
+        // Sends queued datagrams, then queued frames, until the window is full or the pacer
+        // runs dry
+        void drain_send_queue(uint64_t now);
+        // Fills one datagram from the priority queues, false if there was nothing to fill
+        bool pack_queued_frames();
+        // Writes the header and sends, reliable datagrams are tracked until acked
+        void transmit(QueuedDatagram& queued, uint64_t now);
+        // Pacing follows the window over the smoothed RTT
+        void update_pacing_rate() noexcept;
 
-        packets::FrameHeader make_header() const noexcept {
-            return packets::FrameHeader{.sequence_number = this->next_expected_seq};
+        void process_ack(BinaryBuffer buffer);
+        void process_nack(BinaryBuffer buffer);
+
+        // Packs the reliable frames of an unacked datagram into new datagrams
+        void resend(uint24_t sequence);
+
+        // receipt only matters for unreliable frames, reliable ones are looked up by index.
+        // False if a new datagram was needed and there was no buffer for it, the frame has to
+        // stay queued then, see reserve_outgoing
+        bool append_frame(
+            const packets::FrameInfo& info, std::span<const uint8_t> body,
+            std::optional<uint32_t> receipt = std::nullopt
+        );
+        void send_split(
+            packets::FrameInfo info, std::span<const uint8_t> body, const SharedBody& shared,
+            SendPriority priority, std::optional<uint32_t> receipt
+        );
+        // Rents the next datagram, unless this client holds its share of the pool already or
+        // the pool is down to the send reserve
+        std::optional<RentedBuffer> reserve_outgoing() noexcept;
+        // Frames that couldnt get a datagram wait in the queues, Immediate ones as High
+        void requeue_frame(
+            const packets::FrameInfo& info, std::span<const uint8_t> body,
+            std::optional<uint32_t> receipt
+        );
+        // Body bytes that fit into one fragment of a frame like info
+        size_t fragment_piece_size(packets::FrameInfo info) const noexcept;
+        // Marks every reliable frame of an acked datagram, only called if one had a receipt
+        void ack_receipts(SentDatagram& sent);
+        // Hands whatever receipt events piled up to the event channel and the debugger
+        void deliver_receipts();
+
+        // Consecutive sequence numbers extend the last range instead of adding one
+        void push_ack(uint24_t sequence) {
+            if (!this->pending_acks.empty() && this->pending_acks.back().end + 1 == sequence) {
+                this->pending_acks.back().end = sequence;
+            } else {
+                this->pending_acks.push_back({.start = sequence, .end = sequence});
+            }
         }
 
-        std::span<uint8_t>
-        ready_buffer(const BinaryBuffer& buffer, packets::FrameReliability rely);
+        // At most one ACK and one NACK datagram per tick
+        void send_acknowledgements();
+        void send_ack_records(PacketId id, std::vector<packets::SequenceRange>& pending);
+
+        // Biggest frame set we can send without the IP layer fragmenting it
+        size_t max_datagram_size() const noexcept {
+            return std::max(size_t{this->mtu}, size_t{576}) - UDP_HEADER_OVERHEAD;
+        }
 
     private:
-        uint24_t                   next_expected_seq{0};
+        uint24_t                   send_sequence{0};
         uint24_t                   sending_rely_frame_index{0};
         uint64_t                   guid{};
         IRakServerDebugInstrument* debugger{nullptr};
@@ -84,75 +265,218 @@ namespace rakro {
         detail::IPV4Addr           address{};
         uint64_t                   last_packet{detail::time_since_epoch()};
         uint64_t                   server_start_time{};
-
-        std::unordered_set<uint24_t>               missing_packets{};
-        std::unordered_map<uint24_t, BinaryBuffer> ack_buffer{};
-
-        // List of the next expected order number
-        std::array<uint32_t, MAX_ORDER_CHANNELS>        ordered_buffer_next_packets{};
-        std::unordered_map<OrderKey, PacketInformation> out_of_order_packet_buffer{};
-        // Stores any packets which arrived earlier than expected
+        PayloadPipeline            payload{};
+
+        ReceiveWindow received{};
+        // Received and missing datagrams we still have to tell the client about
+        std::vector<packets::SequenceRange> pending_acks{};
+        std::vector<packets::SequenceRange> pending_nacks{};
+        std::vector<packets::SequenceRange> nack_scratch{};
+        bool                                acks_sent_this_tick{false};
+        // Reliable frame indices, so a frame resent in a new datagram is only handled once
+        ReceiveWindow  received_reliable{MAX_RELIABLE_GAP};
+        DuplicateStats duplicates{};
+        // Sent datagrams holding reliable frames, by datagram sequence number, until acked
+        InFlightWindow        in_flight{};
+        RetransmitTimers      retransmit_timers{};
+        RttEstimator          rtt{};
+        std::vector<uint24_t> in_flight_scratch{};
+
+        // Frame set being filled, the header is only written once it goes out
+        BinaryBuffer     outgoing{};
+        size_t           outgoing_frames{0};
+        bool             outgoing_reliable{false};
+        DatagramReceipts outgoing_receipts{};
+
+        size_t                              send_buffer_limit{0}; // See CLIENT_SEND_SHARE
+        std::unique_ptr<ICongestionControl> congestion{};
+        Pacer                               pacer{};
+        size_t                              bytes_in_flight{0};
+        std::deque<QueuedDatagram>          send_queue{}; // Resends and Immediate frames
+        PriorityFrameQueues                 frame_queues{};
+
+        FragmentAssembler fragments{};
+        uint16_t          split_compound_id{0};
+
+        OrderingChannels ordering{};
+
+        ReceiptTracker receipts{};
 
         // Stores the next expected sequence number
-        std::array<uint32_t, MAX_ORDER_CHANNELS> sequenced_packets_next_packet{};
+        std::array<uint24_t, MAX_ORDER_CHANNELS> sequenced_packets_next_packet{};
+        // Next order and sequence index we send with, per channel
+        std::array<uint24_t, MAX_ORDER_CHANNELS> sending_order_index{};
+        std::array<uint24_t, MAX_ORDER_CHANNELS> sending_sequence_index{};
+
+        // Set by the router, events go to the game through it. Without one game packets only
+        // reach IRakServerDebugInstrument::unhandled_client_packet
+        EventChannel* events{nullptr};
+        bool          announced{false}; // Connected went out, so Disconnected has to too
+        // Set once the client has to go, the router drops it after process_packet
+        std::optional<DisconnectReason> disconnect_reason{};
+
+        // Owned by the router, see ClientRouter::update
+        TimerHandle idle_timer{};
+        TimerHandle service_timer{};
+        uint64_t    service_at{};
+        uint64_t    keepalive_sent{0};
+        uint64_t    ping_rtt{0};
 
         friend class ClientRouter;
     };
 
     class ClientRouter {
     public:
-        ClientRouter()                    = default;
+        ClientRouter()
+            : idle_timers(detail::time_since_epoch(), SERVICE_RESOLUTION_MS),
+              service_timers(detail::time_since_epoch(), SERVICE_RESOLUTION_MS) {}
         ClientRouter(const ClientRouter&) = delete;
 
+        // Runs once per server tick. Takes what the game queued, then only touches clients
+        // whose timers came up, every service timer but at most MAX_IDLE_EXPIRIES_PER_TICK
+        // idle ones
+        void update(uint64_t now);
+
         bool is_connected(detail::IPV4Addr addr) const noexcept {
             return this->connected_clients.contains(addr);
         }
 
         void route(detail::IPV4Addr address, BinaryBuffer&& buffer) noexcept {
-            if (this->is_connected(address)) {
-                auto& client = this->connected_clients[address];
+            auto* client = this->connected_clients.find(address);
+            if (client == nullptr) {
+                return;
+            }
 
-                const auto current_time = detail::time_since_epoch();
+            const auto current_time = detail::time_since_epoch();
 
-                if (current_time - client.last_packet > this->timeout) {
-                    this->connected_clients.erase(address);
-                    return;
-                }
+            if (current_time - client->last_packet > this->timeout) {
+                this->disconnect(address, *client, DisconnectReason::TimedOut);
+                return;
+            }
+
+            // The idle timer notices the new last_packet once it comes up, no need to move it
+            client->last_packet = current_time;
 
-                client.last_packet = current_time;
+            client->process_packet(std::move(buffer));
 
-                client.process_packet(std::move(buffer));
+            if (client->disconnect_reason.has_value()) {
+                this->disconnect(address, *client, *client->disconnect_reason);
+                return;
             }
+            this->schedule_service(address, *client, current_time, false);
         }
 
         void connect_client(
             detail::UdpSocket* socket, detail::IPV4Addr address, SemiConnectedClient client,
             uint64_t guid, IRakServerDebugInstrument* debugger, BufferCompany* company,
-            uint64_t server_start_time
+            uint64_t server_start_time, CodecPool* codecs, PayloadSettings payload_settings,
+            CongestionAlgorithm congestion_algorithm, ScratchPool* scratch
         ) noexcept {
             if (this->is_connected(address)) {
                 return;
             }
 
-            // const auto current_time = detail::time_since_epoch();
+            auto* connected = this->connected_clients.insert(
+                address,
+                RakroServerClient(
+                    guid, debugger, socket, client.mtu, company, address, server_start_time,
+                    codecs, payload_settings, congestion_algorithm, scratch
+                )
+            ).first;
+
+            connected->events     = &this->events;
+            connected->idle_timer =
+                this->idle_timers.arm(connected->last_packet + this->keepalive_after, address);
+        }
+
+        size_t get_client_count() const noexcept { return this->connected_clients.size(); }
 
-            // for (const auto& [addr, our_client] : this->connected_clients) {
-            //     if (current_time - our_client.last_packet > this->timeout) {
-            //         this->connected_clients.erase(addr);
-            //     }
-            // }
+        // Game thread only, see EventChannel
+        size_t poll(std::span<Event> out) { return this->events.poll(out); }
 
-            this->connected_clients.insert(
-                {address,
-                 RakroServerClient(
-                     guid, debugger, socket, client.mtu, company, address, server_start_time
-                 )}
+        // Game packets dropped because the game stopped polling, from any thread
+        uint64_t get_dropped_events() const noexcept { return this->events.get_dropped(); }
+
+        // Any thread, the messages go out from the next tick on. Returns how many were queued,
+        // see Outbox
+        size_t send(std::span<const OutgoingMessage> messages) {
+            return this->outbox.push(messages);
+        }
+        template <typename Get> size_t send(size_t count, Get&& get) {
+            return this->outbox.push(count, std::forward<Get>(get));
+        }
+
+        // Any thread. Queues broadcast for recipients, or for every client but them with
+        // everyone set, in one slot. False if the outbox was full
+        bool broadcast(
+            const Broadcast& broadcast, std::span<const ClientHandle> recipients, bool everyone
+        ) {
+            return this->broadcast(broadcast, everyone, recipients.size(), [&](size_t index) {
+                return recipients[index];
+            });
+        }
+        template <typename Get>
+        bool broadcast(const Broadcast& broadcast, bool everyone, size_t count, Get&& get) {
+            return this->outbox.push_broadcast(
+                broadcast, everyone, count, std::forward<Get>(get)
             );
         }
 
+        // Any thread. Swaps the client's PayloadSettings in between its queued sends, see
+        // Outbox::push_settings. False if the outbox was full
+        bool
+        update_payload_settings(const ClientHandle& client, const PayloadSettings& settings) {
+            return this->outbox.push_settings(client, settings);
+        }
+
+    private:
+        void on_idle(detail::IPV4Addr address, RakroServerClient& client, uint64_t now);
+        void on_service(detail::IPV4Addr address, RakroServerClient& client, uint64_t now);
+
+        // Hands queued sends to their clients, a handle whose client is gone is dropped
+        void drain_outbox(uint64_t now);
+        void send_broadcast(const QueuedSend& send, uint64_t now);
+        // The broadcast body as client has to get it, a batch of one with its pipeline on.
+        // Encoded once per distinct settings a broadcast runs into. Null if it didnt encode
+        SharedBody broadcast_body(const SharedBody& packet, RakroServerClient& client);
+
+        // Arms the service timer for whatever next_service says. Unless reset is set, a timer
+        // that is already armed only ever moves to an earlier tick
+        void schedule_service(
+            detail::IPV4Addr address, RakroServerClient& client, uint64_t now, bool reset
+        );
+
+        void disconnect(
+            detail::IPV4Addr address, RakroServerClient& client, DisconnectReason reason
+        ) noexcept {
+            // Before Disconnected, so nobody is left waiting on a receipt for a client the game
+            // was already told is gone
+            client.abandon_receipts();
+
+            if (client.announced) {
+                this->events.push(Event{
+                    .type = EventType::Disconnected, .client = client.handle(), .reason = reason
+                });
+            }
+
+            this->idle_timers.cancel(client.idle_timer);
+            this->service_timers.cancel(client.service_timer);
+            this->connected_clients.erase(address);
+        }
+
     private:
-        std::unordered_map<detail::IPV4Addr, RakroServerClient> connected_clients{};
-        uint64_t                                                timeout{5000};
+        AddressTable<RakroServerClient> connected_clients{};
+        TimerWheel<detail::IPV4Addr>    idle_timers;    // Keepalive and timeout checks
+        TimerWheel<detail::IPV4Addr>    service_timers; // Acks, queued frames and resends
+        EventChannel                    events{};
+        Outbox                          outbox{};
+        std::vector<uint64_t>           excluded{}; // Scratch for send_broadcast
+        std::vector<uint8_t>            encoded{};  // Scratch for send_message
+        uint64_t                        timeout{5000};
+        uint64_t                        keepalive_after{2000}; // Silence before we ping them
+
+        // Bodies of the broadcast being sent, one per PayloadSettings, see broadcast_body
+        std::vector<std::pair<PayloadSettings, SharedBody>> batched_bodies{};
     };
 
 } // namespace rakro
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <chrono>
+#include <rakro/server/shards.hpp>
+
+namespace rakro {
+
+    ShardedRouter::ShardedRouter(
+        size_t worker_count, uint32_t update_interval_ms, size_t queue_capacity
+    )
+        : update_interval_ms(std::max(update_interval_ms, uint32_t{1})) {
+        this->shards.reserve(worker_count);
+
+        for (size_t index = 0; index < worker_count; index++) {
+            this->shards.push_back(std::make_unique<Shard>(queue_capacity));
+        }
+
+        // Only started once every shard exists, the vector never moves after this
+        for (auto& shard : this->shards) {
+            shard->thread = std::jthread([this, &shard = *shard](std::stop_token stop) {
+                this->run(shard, stop);
+            });
+        }
+    }
+
+    ShardedRouter::~ShardedRouter() {
+        for (auto& shard : this->shards) {
+            shard->thread.request_stop();
+            shard->wakeup.release();
+        }
+
+        for (auto& shard : this->shards) {
+            if (shard->thread.joinable()) {
+                shard->thread.join();
+            }
+        }
+    }
+
+    void ShardedRouter::route(detail::IPV4Addr address, BinaryBuffer&& datagram) {
+        (void)this->push(ShardMessage{.address = address, .datagram = std::move(datagram)});
+    }
+
+    bool ShardedRouter::connect(
+        detail::IPV4Addr address, SemiConnectedClient client, uint64_t guid,
+        const ClientSettings& settings
+    ) {
+        return this->push(ShardMessage{
+            .address = address,
+            .connection =
+                PendingConnection{.client = client, .guid = guid, .settings = settings}
+        });
+    }
+
+    void ShardedRouter::wake() {
+        for (auto& shard : this->shards) {
+            if (shard->needs_wake) {
+                shard->needs_wake = false;
+                shard->wakeup.release();
+            }
+        }
+    }
+
+    void ShardedRouter::update(uint64_t now) {
+        if (this->shards.empty()) {
+            this->inline_router.update(now);
+        }
+    }
+
+    template <typename HandleOf>
+    ShardedRouter::ShardGroups
+    ShardedRouter::group_by_shard(size_t count, HandleOf&& handle_of) const {
+        // Kept per thread so a game tick doesnt allocate
+        thread_local std::vector<uint32_t> shard_index{};
+        thread_local std::vector<uint32_t> order{};
+        thread_local std::vector<uint32_t> starts{};
+        thread_local std::vector<uint32_t> next{};
+
+        shard_index.resize(count);
+        order.resize(count);
+        starts.assign(this->shards.size() + 1, 0);
+
+        for (size_t index = 0; index < count; index++) {
+            const ClientHandle& handle = handle_of(index);
+
+            shard_index[index] = static_cast<uint32_t>(this->shard_of(handle.address));
+            starts[shard_index[index] + 1]++;
+        }
+        for (size_t index = 0; index < this->shards.size(); index++) {
+            starts[index + 1] += starts[index];
+        }
+
+        // Counting sort, so items keep their order within a shard
+        next.assign(starts.begin(), starts.end());
+        for (size_t index = 0; index < count; index++) {
+            order[next[shard_index[index]]++] = static_cast<uint32_t>(index);
+        }
+
+        return ShardGroups{.order = order, .starts = starts};
+    }
+
+    size_t ShardedRouter::send(std::span<const OutgoingMessage> messages) {
+        if (this->shards.empty()) {
+            return this->inline_router.send(messages);
+        }
+        if (messages.size() == 1) {
+            return this->shards[this->shard_of(messages[0].client.address)]->router.send(
+                messages
+            );
+        }
+
+        // Every shard gets its messages in a single push
+        const auto groups = this->group_by_shard(messages.size(), [&](size_t index) {
+            return messages[index].client;
+        });
+
+        size_t queued = 0;
+        for (size_t index = 0; index < this->shards.size(); index++) {
+            const auto first = groups.starts[index];
+            queued += this->shards[index]->router.send(
+                groups.starts[index + 1] - first,
+                [&](size_t offset) -> const OutgoingMessage& {
+                    return messages[groups.order[first + offset]];
+                }
+            );
+        }
+        return queued;
+    }
+
+    bool ShardedRouter::broadcast(
+        const Broadcast& broadcast, std::span<const ClientHandle> clients, bool everyone
+    ) {
+        if (this->shards.empty()) {
+            return this->inline_router.broadcast(broadcast, clients, everyone);
+        }
+
+        const auto groups = this->group_by_shard(clients.size(), [&](size_t index) {
+            return clients[index];
+        });
+
+        bool queued = true;
+        for (size_t index = 0; index < this->shards.size(); index++) {
+            const auto first = groups.starts[index];
+            const auto count = groups.starts[index + 1] - first;
+
+            // Without everyone a shard none of the recipients are on has nothing to do
+            if (count == 0 && !everyone) {
+                continue;
+            }
+
+            queued &= this->shards[index]->router.broadcast(
+                broadcast, everyone, count,
+                [&](size_t offset) { return clients[groups.order[first + offset]]; }
+            );
+        }
+        return queued;
+    }
+
+    bool ShardedRouter::update_payload_settings(
+        const ClientHandle& client, const PayloadSettings& settings
+    ) {
+        if (this->shards.empty()) {
+            return this->inline_router.update_payload_settings(client, settings);
+        }
+        return this->shards[this->shard_of(client.address)]->router.update_payload_settings(
+            client, settings
+        );
+    }
+
+    size_t ShardedRouter::poll(std::span<Event> out) {
+        if (this->shards.empty()) {
+            return this->inline_router.poll(out);
+        }
+
+        const auto count = this->shards.size();
+        const auto first = this->next_poll++ % count;
+
+        size_t filled = 0;
+        for (size_t offset = 0; offset < count && filled < out.size(); offset++) {
+            auto& shard = *this->shards[(first + offset) % count];
+            filled += shard.router.poll(out.subspan(filled));
+        }
+        return filled;
+    }
+
+    ShardStats ShardedRouter::get_stats() const noexcept {
+        auto stats           = this->inline_stats;
+        stats.dropped_events = this->inline_router.get_dropped_events();
+
+        for (const auto& shard : this->shards) {
+            stats.handled += shard->handled.load(std::memory_order_relaxed);
+            stats.dropped += shard->dropped.load(std::memory_order_relaxed);
+            stats.dropped_events += shard->router.get_dropped_events();
+        }
+        return stats;
+    }
+
+    void ShardedRouter::deliver(ClientRouter& router, ShardMessage&& message) {
+        if (!message.connection.has_value()) {
+            router.route(message.address, std::move(message.datagram));
+            return;
+        }
+
+        const auto& connection = *message.connection;
+        const auto& settings   = connection.settings;
+
+        router.connect_client(
+            settings.socket, message.address, connection.client, connection.guid,
+            settings.debugger, settings.company, settings.server_start_time, settings.codecs,
+            settings.payload, settings.congestion, settings.scratch
+        );
+    }
+
+    size_t ShardedRouter::shard_of(const detail::IPV4Addr& address) const noexcept {
+        // std::hash only mixes the port in lightly, the multiply spreads it over the high
+        // bits before picking a shard
+        const auto hash  = std::hash<detail::IPV4Addr>{}(address);
+        const auto mixed = (static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull) >> 32;
+        return static_cast<size_t>(mixed % this->shards.size());
+    }
+
+    bool ShardedRouter::push(ShardMessage&& message) {
+        if (this->shards.empty()) {
+            deliver(this->inline_router, std::move(message));
+            this->inline_stats.handled++;
+            return true;
+        }
+
+        auto& shard = *this->shards[this->shard_of(message.address)];
+
+        // UDP can drop it anyway, the client resends whatever was reliable
+        if (!shard.queue.try_push(std::move(message))) {
+            shard.dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        shard.needs_wake = true;
+        return true;
+    }
+
+    void ShardedRouter::run(Shard& shard, std::stop_token stop) {
+        auto last_update = detail::time_since_epoch();
+
+        while (!stop.stop_requested()) {
+            while (auto message = shard.queue.try_pop()) {
+                deliver(shard.router, std::move(*message));
+                shard.handled.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            const auto now = detail::time_since_epoch();
+            if (now - last_update >= this->update_interval_ms) {
+                last_update = now;
+                shard.router.update(now);
+            }
+
+            // Sleeps until the listener hands something over or the next tick is due
+            const auto interval   = uint64_t{this->update_interval_ms};
+            const auto until_tick = interval - std::min(now - last_update, interval);
+            shard.wakeup.try_acquire_for(
+                std::chrono::milliseconds(std::max(until_tick, uint64_t{1}))
+            );
+        }
+    }
+} // namespace rakro
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "rakro/internal/binary_buffer.hpp"
+#include "rakro/internal/buffer_company.hpp"
+#include "rakro/internal/net.hpp"
+#include "rakro/internal/spsc_queue.hpp"
+#include "rakro/server/server_client.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <semaphore>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace rakro {
+
+    // Datagrams a worker can have waiting before the listener starts dropping them. Every one
+    // of them holds a rented buffer, see shard_queue_capacity for what it gets cut down to
+    constexpr size_t SHARD_QUEUE_CAPACITY = 256;
+    // The worker queues together never hold more than 1 / SHARD_POOL_SHARE of the pool, the
+    // rest is left for ingress, admission and the send path
+    constexpr size_t SHARD_POOL_SHARE = 2;
+
+    // Capacity of each of worker_count queues, SHARD_QUEUE_CAPACITY unless that many full
+    // queues would take more than their share of company. The queues round up to a power of
+    // two, so this rounds down to one, and never goes under 2, the smallest queue there is
+    inline size_t
+    shard_queue_capacity(const BufferCompany& company, size_t worker_count) noexcept {
+        if (worker_count == 0) {
+            return SHARD_QUEUE_CAPACITY;
+        }
+
+        const auto share = company.get_capacity() / SHARD_POOL_SHARE / worker_count;
+        return std::bit_floor(std::clamp(share, size_t{2}, SHARD_QUEUE_CAPACITY));
+    }
+
+    // Everything a router needs to create a client, the same for every connection
+    struct ClientSettings {
+        detail::UdpSocket*         socket{nullptr};
+        IRakServerDebugInstrument* debugger{nullptr};
+        BufferCompany*             company{nullptr};
+        uint64_t                   server_start_time{};
+        CodecPool*                 codecs{nullptr};
+        PayloadSettings            payload{};
+        CongestionAlgorithm        congestion{};
+        ScratchPool*               scratch{nullptr};
+    };
+
+    struct ShardStats {
+        uint64_t handled{0}; // Datagrams and connects a worker got through
+        uint64_t dropped{0}; // Turned away because the worker was behind
+        // Game packets dropped because the game was too far behind on polling
+        uint64_t dropped_events{0};
+    };
+
+    // Spreads connections over a fixed set of worker threads, every worker runs its own
+    // ClientRouter and ticks it itself. A connection is pinned to one worker by its address,
+    // and the listener hands its datagrams over through that worker's SPSC queue, so they
+    // are processed in the order they arrived. Workers send straight to the socket.
+    //
+    // With 0 workers everything runs on the listener thread instead, the same as using a
+    // ClientRouter directly
+    class ShardedRouter {
+    public:
+        explicit ShardedRouter(
+            size_t worker_count = 0, uint32_t update_interval_ms = 10,
+            size_t queue_capacity = SHARD_QUEUE_CAPACITY
+        );
+        ShardedRouter(const ShardedRouter&) = delete;
+        ~ShardedRouter();
+
+        // Everything but poll is for the listener thread only
+
+        void route(detail::IPV4Addr address, BinaryBuffer&& datagram);
+
+        // False if the client's worker was too far behind to take it, nothing was added then
+        bool connect(
+            detail::IPV4Addr address, SemiConnectedClient client, uint64_t guid,
+            const ClientSettings& settings
+        );
+
+        // Wakes every worker that was handed something since the last call, meant to be
+        // called once per ingress batch rather than once per datagram
+        void wake();
+
+        // Ticks the inline router, workers keep their own time
+        void update(uint64_t now);
+
+        // Any thread. Hands every worker its part of messages with one CAS, returns how many
+        // were queued. Less than messages.size() means some worker's outbox was full
+        size_t send(std::span<const OutgoingMessage> messages);
+
+        // Any thread. One slot per worker that has any of clients, or every worker with
+        // everyone set, then clients are the ones left out. False if some worker was full
+        bool broadcast(
+            const Broadcast& broadcast, std::span<const ClientHandle> clients, bool everyone
+        );
+
+        // Any thread. Goes through the client's worker like a send, so sends queued for it
+        // before this still use the old settings. False if that worker's outbox was full
+        bool
+        update_payload_settings(const ClientHandle& client, const PayloadSettings& settings);
+
+        // Game thread only. Takes events from every worker in turn, starting one further each
+        // call so a busy worker cant starve the rest
+        size_t poll(std::span<Event> out);
+
+        size_t     get_worker_count() const noexcept { return this->shards.size(); }
+        ShardStats get_stats() const noexcept;
+
+    private:
+        struct PendingConnection {
+            SemiConnectedClient client{};
+            uint64_t            guid{};
+            ClientSettings      settings{};
+        };
+
+        // A datagram for a client, or a client to add when connection is set
+        struct ShardMessage {
+            detail::IPV4Addr                 address{};
+            BinaryBuffer                     datagram{};
+            std::optional<PendingConnection> connection{};
+        };
+
+        struct Shard {
+            explicit Shard(size_t queue_capacity) : queue(queue_capacity) {}
+
+            SpscQueue<ShardMessage>   queue;
+            std::counting_semaphore<> wakeup{0};
+            ClientRouter              router{};
+            std::atomic<uint64_t>     handled{0};
+            std::atomic<uint64_t>     dropped{0};
+            bool                      needs_wake{false}; // Listener side only
+            std::jthread              thread{};
+        };
+
+        static void deliver(ClientRouter& router, ShardMessage&& message);
+
+        size_t shard_of(const detail::IPV4Addr& address) const noexcept;
+
+        // Indexes of a batch sorted by shard, keeping their order within one. Shard s gets
+        // order[starts[s]] up to order[starts[s + 1]]. Only valid until the next call on the
+        // same thread
+        struct ShardGroups {
+            std::span<const uint32_t> order{};
+            std::span<const uint32_t> starts{};
+        };
+
+        template <typename HandleOf>
+        ShardGroups group_by_shard(size_t count, HandleOf&& handle_of) const;
+
+        // False if the worker's queue was full and message was dropped
+        bool push(ShardMessage&& message);
+        void run(Shard& shard, std::stop_token stop);
+
+    private:
+        std::vector<std::unique_ptr<Shard>> shards{};
+        ClientRouter                        inline_router{};
+        ShardStats                          inline_stats{};
+        size_t                              next_poll{0}; // Game side
+        uint32_t                            update_interval_ms{10};
+    };
+} // namespace rakro